@@ -25,6 +25,7 @@
 #include <bitcoin/node/protocols/protocol_block_in.hpp>
 #include <bitcoin/node/protocols/protocol_block_out.hpp>
 #include <bitcoin/node/protocols/protocol_block_sync.hpp>
+#include <bitcoin/node/protocols/protocol_filter_out.hpp>
 #include <bitcoin/node/protocols/protocol_header_in.hpp>
 #include <bitcoin/node/protocols/protocol_transaction_in.hpp>
 #include <bitcoin/node/protocols/protocol_transaction_out.hpp>
@@ -32,11 +33,25 @@
 #include <bitcoin/node/sessions/session_inbound.hpp>
 #include <bitcoin/node/sessions/session_manual.hpp>
 #include <bitcoin/node/sessions/session_outbound.hpp>
+#include <bitcoin/node/utility/block_filter.hpp>
+#include <bitcoin/node/utility/bloom_filter.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/download_budget.hpp>
+#include <bitcoin/node/utility/filter_index.hpp>
 #include <bitcoin/node/utility/hash_queue.hpp>
+#include <bitcoin/node/utility/orphan_pool.hpp>
+#include <bitcoin/node/utility/outbound_scaler.hpp>
+#include <bitcoin/node/utility/peer_history.hpp>
 #include <bitcoin/node/utility/performance.hpp>
+#include <bitcoin/node/utility/pool_index.hpp>
+#include <bitcoin/node/utility/relay_buckets.hpp>
 #include <bitcoin/node/utility/reservation.hpp>
 #include <bitcoin/node/utility/reservations.hpp>
+#include <bitcoin/node/utility/rolling_filter.hpp>
 #include <bitcoin/node/utility/statistics.hpp>
+#include <bitcoin/node/utility/sync_phase.hpp>
+#include <bitcoin/node/utility/timing_wheel.hpp>
+#include <bitcoin/node/utility/transaction_requests.hpp>
+#include <bitcoin/node/utility/upload_scheduler.hpp>
 
 #endif
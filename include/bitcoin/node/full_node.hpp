@@ -19,13 +19,25 @@
 #ifndef LIBBITCOIN_NODE_FULL_NODE_HPP
 #define LIBBITCOIN_NODE_FULL_NODE_HPP
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/configuration.hpp>
 #include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/filter_index.hpp>
+#include <bitcoin/node/utility/orphan_pool.hpp>
+#include <bitcoin/node/utility/outbound_scaler.hpp>
+#include <bitcoin/node/utility/peer_history.hpp>
+#include <bitcoin/node/utility/pool_index.hpp>
+#include <bitcoin/node/utility/relay_buckets.hpp>
 #include <bitcoin/node/utility/reservations.hpp>
+#include <bitcoin/node/utility/rolling_filter.hpp>
+#include <bitcoin/node/utility/sync_phase.hpp>
+#include <bitcoin/node/utility/timing_wheel.hpp>
+#include <bitcoin/node/utility/transaction_requests.hpp>
+#include <bitcoin/node/utility/upload_scheduler.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -83,6 +95,45 @@ public:
     /// Get a download reservation manager.
     virtual reservation::ptr get_reservation();
 
+    /// Record a header announcement for direct download from the channel.
+    virtual void announce(const hash_digest& hash, uint64_t channel);
+
+    /// Node-wide persistent block download performance by peer address.
+    virtual peer_history& history();
+
+    /// Node-wide outbound connection target, scaled while syncing.
+    virtual outbound_scaler& scaler();
+
+    /// Node-wide block sync phase, holding channels pending relay protocols.
+    virtual sync_phase& phase();
+
+    /// Node-wide thread pool for block import and store writes.
+    virtual threadpool& store_pool();
+
+    /// Node-wide timing wheel for block download deadlines.
+    virtual timing_wheel& deadlines();
+
+    /// Node-wide block upload scheduler.
+    virtual upload_scheduler& uploads();
+
+    /// Node-wide compact block filter index.
+    virtual filter_index& filters();
+
+    /// Node-wide in-flight transaction request tracker.
+    virtual transaction_requests& requests();
+
+    /// Node-wide orphan transaction pool.
+    virtual orphan_pool& orphans();
+
+    /// Node-wide filter of recently rejected transaction hashes.
+    virtual rolling_filter& rejected();
+
+    /// Node-wide fee rate index of pool transactions.
+    virtual pool_index& mempool();
+
+    /// Node-wide transaction relay fan-out by peer fee filter.
+    virtual relay_buckets& relay();
+
     // Subscriptions.
     // ------------------------------------------------------------------------
 
@@ -118,11 +169,53 @@ private:
         block_const_ptr_list_const_ptr incoming,
         block_const_ptr_list_const_ptr outgoing);
 
+    bool handle_transaction(code ec, transaction_const_ptr tx);
+    void organize_orphans(const hash_digest& parent);
+    void handle_orphan(const code& ec, transaction_const_ptr tx);
+
     void handle_running(const code& ec, result_handler handler);
+    void handle_frontier(const code& ec);
+    void handle_distribute(const code& ec);
+    void handle_scaling(const code& ec);
+    bool start_filters();
+    void catch_up_filters();
+    bool populate_prevouts(const chain::block& block);
+    void handle_mempool(const code& ec);
+    void handle_fetch_mempool(const code& ec, inventory_ptr page,
+        uint64_t sequence);
+
+    struct pooled_fee
+    {
+        transaction_const_ptr tx;
+        std::atomic<uint64_t> value;
+        std::atomic<size_t> remaining;
+        std::atomic<bool> missing;
+    };
+
+    typedef std::shared_ptr<pooled_fee> pooled_fee_ptr;
+
+    void index_pooled(const hash_list& hashes);
+    void handle_fetch_pooled(const code& ec, transaction_const_ptr tx,
+        size_t position);
+    void handle_fetch_previous(const code& ec, transaction_const_ptr previous,
+        uint32_t index, pooled_fee_ptr fee);
 
     // These are thread safe.
+    threadpool store_pool_;
     reservations reservations_;
+    peer_history history_;
+    outbound_scaler scaler_;
+    sync_phase phase_;
+    timing_wheel deadlines_;
+    upload_scheduler uploads_;
+    filter_index filters_;
+    transaction_requests requests_;
+    orphan_pool orphans_;
+    rolling_filter rejected_;
+    pool_index mempool_;
+    relay_buckets relay_;
     blockchain::block_chain chain_;
+    std::atomic<bool> distributing_;
     const uint32_t protocol_maximum_;
     const node::settings& node_settings_;
     const blockchain::settings& chain_settings_;
@@ -26,6 +26,9 @@
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/bloom_filter.hpp>
+#include <bitcoin/node/utility/rolling_filter.hpp>
+#include <bitcoin/node/utility/upload_scheduler.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -49,10 +52,13 @@ private:
     size_t locator_limit();
 
     void send_next_data(inventory_ptr inventory);
+    void handle_upload(const code& ec, inventory_ptr inventory);
     void send_block(const code& ec, block_const_ptr message,
         size_t height, inventory_ptr inventory);
     void send_merkle_block(const code& ec, merkle_block_const_ptr message,
         size_t height, inventory_ptr inventory);
+    void send_filtered_block(const code& ec, block_const_ptr message,
+        size_t height, inventory_ptr inventory);
     void send_compact_block(const code& ec, compact_block_const_ptr message,
         size_t height, inventory_ptr inventory);
 
@@ -66,11 +72,23 @@ private:
         send_headers_const_ptr message);
     bool handle_receive_send_compact(const code& ec,
         send_compact_const_ptr message);
+    bool handle_receive_filter_load(const code& ec,
+        filter_load_const_ptr message);
+    bool handle_receive_filter_add(const code& ec,
+        filter_add_const_ptr message);
+    bool handle_receive_filter_clear(const code& ec,
+        filter_clear_const_ptr message);
+    bool handle_receive_inventory(const code& ec,
+        inventory_const_ptr message);
+    bool handle_receive_headers(const code& ec, headers_const_ptr message);
+    bool is_announceable(const chain::header& header);
 
     void handle_fetch_locator_hashes(const code& ec, inventory_ptr message);
     void handle_fetch_locator_headers(const code& ec, headers_ptr message);
 
     void handle_stop(const code& ec);
+    void handle_upload_sent(const code& ec, size_t size,
+        inventory_ptr inventory);
     void handle_send_next(const code& ec, inventory_ptr inventory);
     bool handle_reorganized(code ec, size_t fork_height,
         block_const_ptr_list_const_ptr incoming,
@@ -79,10 +97,16 @@ private:
     // These are thread safe.
     full_node& node_;
     blockchain::safe_chain& chain_;
+    upload_scheduler& uploads_;
     bc::atomic<hash_digest> last_locator_top_;
     std::atomic<bool> compact_to_peer_;
     std::atomic<bool> headers_to_peer_;
     const bool enable_witness_;
+    rolling_filter known_;
+
+    // Protected by filter mutex.
+    bloom_filter::ptr filter_;
+    mutable upgrade_mutex filter_mutex_;
 };
 
 } // namespace node
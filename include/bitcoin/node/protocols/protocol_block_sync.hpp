@@ -20,11 +20,16 @@
 #define LIBBITCOIN_NODE_PROTOCOL_BLOCK_SYNC_HPP
 
 #include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <utility>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/peer_history.hpp>
 #include <bitcoin/node/utility/reservation.hpp>
+#include <bitcoin/node/utility/timing_wheel.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -33,7 +38,7 @@ class full_node;
 
 /// Blocks sync protocol, thread safe.
 class BCN_API protocol_block_sync
-  : public network::protocol_timer, public track<protocol_block_sync>
+  : public network::protocol_events, public track<protocol_block_sync>
 {
 public:
     typedef std::shared_ptr<protocol_block_sync> ptr;
@@ -47,19 +52,38 @@ public:
 
 protected:
     // Expose polymorphic start method from base.
-    using network::protocol_timer::start;
+    using network::protocol_events::start;
 
 private:
+    typedef std::pair<block_const_ptr, size_t> pending_block;
+
     void send_get_blocks();
-    void handle_event(const code& ec);
+    bool partitioned() const;
+    void set_deadline();
+    void expire(bool stalled);
+    void handle_stop(const code& ec);
+    void handle_wake(const code& ec);
+    void handle_deadline(const code& ec);
     bool handle_receive_block(const code& ec, block_const_ptr message);
-    bool handle_reindexed(code ec, size_t fork_height,
-        header_const_ptr_list_const_ptr incoming,
-        header_const_ptr_list_const_ptr outgoing);
+    void handle_import(block_const_ptr message, size_t height);
+
+    void record_history(const code& reason);
 
     blockchain::safe_chain& chain_;
+    peer_history& history_;
+    timing_wheel& deadlines_;
+    threadpool& store_;
+    const asio::duration block_latency_;
 
     reservation::ptr reservation_;
+
+    // Protected by mutex.
+    bool stalled_;
+    bool importing_;
+    std::deque<pending_block> pending_;
+    uint32_t latency_;
+    asio::time_point requested_;
+    asio::time_point active_;
     mutable upgrade_mutex mutex_;
 };
 
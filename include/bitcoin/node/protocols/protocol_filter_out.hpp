@@ -0,0 +1,68 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_PROTOCOL_FILTER_OUT_HPP
+#define LIBBITCOIN_NODE_PROTOCOL_FILTER_OUT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/blockchain.hpp>
+#include <bitcoin/network.hpp>
+#include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/filter_index.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+class full_node;
+
+/// Serves BIP157 compact block filters from the node filter index.
+class BCN_API protocol_filter_out
+  : public network::protocol_events, track<protocol_filter_out>
+{
+public:
+    typedef std::shared_ptr<protocol_filter_out> ptr;
+
+    /// Construct a filter protocol instance.
+    protocol_filter_out(full_node& network, network::channel::ptr channel);
+
+    /// Start the protocol.
+    virtual void start();
+
+private:
+    bool handle_unavailable();
+    bool get_stop_height(size_t& out_height, uint8_t filter_type,
+        size_t start_height, const hash_digest& stop_hash,
+        size_t limit) const;
+
+    bool handle_receive_get_filters(const code& ec,
+        get_compact_filters_const_ptr message);
+    bool handle_receive_get_filter_headers(const code& ec,
+        get_compact_filter_headers_const_ptr message);
+    bool handle_receive_get_filter_checkpoint(const code& ec,
+        get_compact_filter_checkpoint_const_ptr message);
+
+    // This is thread safe.
+    filter_index& filters_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -24,6 +24,9 @@
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/orphan_pool.hpp>
+#include <bitcoin/node/utility/rolling_filter.hpp>
+#include <bitcoin/node/utility/transaction_requests.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -31,32 +34,42 @@ namespace node {
 class full_node;
 
 class BCN_API protocol_transaction_in
-  : public network::protocol_events, track<protocol_transaction_in>
+  : public network::protocol_timer, track<protocol_transaction_in>
 {
 public:
     typedef std::shared_ptr<protocol_transaction_in> ptr;
 
     /// Construct a transaction protocol instance.
     protocol_transaction_in(full_node& network, network::channel::ptr channel,
-        blockchain::safe_chain& chain);
+        blockchain::safe_chain& chain, bool outbound);
 
     /// Start the protocol.
-    virtual void start();
+    void start() override;
+
+protected:
+    // Expose polymorphic start method from base.
+    using network::protocol_timer::start;
 
 private:
     void send_get_transactions(transaction_const_ptr message);
     void send_get_data(const code& ec, get_data_ptr message);
+    void send_request(get_data_ptr message);
 
     bool handle_receive_inventory(const code& ec, inventory_const_ptr message);
+    bool handle_receive_not_found(const code& ec, not_found_const_ptr message);
     bool handle_receive_transaction(const code& ec,
         transaction_const_ptr message);
     void handle_store_transaction(const code& ec,
         transaction_const_ptr message);
 
-    void handle_stop(const code&);
+    void handle_event(const code& ec);
 
     // These are thread safe.
     blockchain::safe_chain& chain_;
+    transaction_requests& requests_;
+    orphan_pool& orphans_;
+    rolling_filter& rejected_;
+    const bool outbound_;
     const uint64_t minimum_relay_fee_;
     const bool relay_from_peer_;
     const bool refresh_pool_;
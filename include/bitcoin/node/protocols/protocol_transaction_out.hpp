@@ -20,11 +20,17 @@
 #define LIBBITCOIN_NODE_PROTOCOL_TRANSACTION_OUT_HPP
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <random>
+#include <unordered_map>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/pool_index.hpp>
+#include <bitcoin/node/utility/relay_buckets.hpp>
+#include <bitcoin/node/utility/rolling_filter.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -45,9 +51,21 @@ public:
     virtual void start();
 
 private:
-    void send_next_data(inventory_ptr inventory);
-    void send_transaction(const code& ec, transaction_const_ptr message,
-        size_t position, size_t height, inventory_ptr inventory);
+    struct data_batch
+    {
+        inventory_vector::list requests;
+        inventory_vector::list missing;
+        transaction_const_ptr_list transactions;
+        size_t offset;
+        std::atomic<size_t> remaining;
+    };
+
+    typedef std::shared_ptr<data_batch> data_batch_ptr;
+
+    void fetch_transactions(data_batch_ptr batch);
+    void send_transactions(data_batch_ptr batch);
+    void send_not_found(data_batch_ptr batch);
+    void handle_send_transactions(const code& ec, data_batch_ptr batch);
 
     bool handle_receive_get_data(const code& ec,
         get_data_const_ptr message);
@@ -56,19 +74,37 @@ private:
     bool handle_receive_memory_pool(const code& ec,
         memory_pool_const_ptr message);
 
-    void handle_fetch_mempool(const code& ec, inventory_ptr message);
+    void send_next_mempool(const pool_index::cursor& after);
+    void handle_send_mempool(const code& ec, const pool_index::cursor& after,
+        bool exhausted);
+
+    void schedule_announcements();
+    void handle_announce(const code& ec);
+    bool handle_receive_inventory(const code& ec,
+        inventory_const_ptr message);
 
     void handle_stop(const code& ec);
-    void handle_send_next(const code& ec, inventory_ptr inventory);
-    bool handle_transaction_pool(const code& ec,
-        transaction_const_ptr message);
+    void handle_fetch_transaction(const code& ec,
+        transaction_const_ptr message, size_t position, data_batch_ptr batch,
+        size_t index);
+    void handle_transaction_pool(transaction_const_ptr message,
+        uint64_t rate);
 
     // These are thread safe.
     blockchain::safe_chain& chain_;
+    pool_index& mempool_;
+    relay_buckets& relay_;
     std::atomic<uint64_t> minimum_peer_fee_;
     ////std::atomic<bool> compact_to_peer_;
     const bool relay_to_peer_;
     const bool enable_witness_;
+    deadline::ptr announce_timer_;
+    rolling_filter known_;
+
+    // Protected by announce mutex.
+    std::mt19937 generator_;
+    std::unordered_map<hash_digest, uint64_t> announcements_;
+    mutable upgrade_mutex announce_mutex_;
 };
 
 } // namespace node
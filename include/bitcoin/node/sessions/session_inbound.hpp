@@ -24,6 +24,7 @@
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/define.hpp>
 #include <bitcoin/node/sessions/session.hpp>
+#include <bitcoin/node/utility/sync_phase.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -44,7 +45,18 @@ protected:
     /// Overridden to attach blockchain protocols.
     void attach_protocols(network::channel::ptr channel) override;
 
+    /// Attach block download protocols, required in both phases.
+    virtual void attach_sync_protocols(network::channel::ptr channel);
+
+    /// Attach announcement and relay protocols once the chain is current.
+    virtual void attach_relay_protocols(network::channel::ptr channel);
+
     blockchain::safe_chain& chain_;
+    const bool compact_filters_;
+
+private:
+    // This is thread safe.
+    sync_phase& phase_;
 };
 
 } // namespace node
@@ -19,11 +19,16 @@
 #ifndef LIBBITCOIN_NODE_SESSION_OUTBOUND_HPP
 #define LIBBITCOIN_NODE_SESSION_OUTBOUND_HPP
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/define.hpp>
 #include <bitcoin/node/sessions/session.hpp>
+#include <bitcoin/node/utility/outbound_scaler.hpp>
+#include <bitcoin/node/utility/peer_history.hpp>
+#include <bitcoin/node/utility/sync_phase.hpp>
 
 namespace libbitcoin {
 namespace node {
@@ -40,11 +45,47 @@ public:
     /// Construct an instance.
     session_outbound(full_node& network, blockchain::safe_chain& chain);
 
+    /// Overridden to add connection loops up to the sync ceiling.
+    void start(result_handler handler) override;
+
 protected:
     /// Overridden to attach blockchain protocols.
     void attach_protocols(network::channel::ptr channel) override;
 
+    /// Attach block download protocols, required in both phases.
+    virtual void attach_sync_protocols(network::channel::ptr channel);
+
+    /// Attach announcement and relay protocols once the chain is current.
+    virtual void attach_relay_protocols(network::channel::ptr channel);
+
+    /// Overridden to park connection attempts above the outbound target and
+    /// to prefer the historically fastest of sampled addresses.
+    void fetch_address(host_handler handler) const override;
+
     blockchain::safe_chain& chain_;
+
+private:
+    struct samples
+    {
+        std::atomic<size_t> remaining;
+        code result;
+        config::authority best;
+        double score;
+        mutable upgrade_mutex mutex;
+    };
+
+    typedef std::shared_ptr<samples> samples_ptr;
+
+    void handle_sync_started(const code& ec, result_handler handler);
+
+    void handle_admit(const code& ec, host_handler handler) const;
+    void handle_fetch_address(const code& ec, const config::authority& host,
+        samples_ptr state, host_handler handler) const;
+
+    // These are thread safe.
+    peer_history& history_;
+    outbound_scaler& scaler_;
+    sync_phase& phase_;
 };
 
 } // namespace node
@@ -36,7 +36,14 @@ public:
     /// Properties.
     float maximum_deviation;
     uint32_t block_latency_seconds;
+    uint32_t sync_outbound_connections;
+    uint32_t download_budget_megabytes;
+    uint32_t download_lookahead_blocks;
+    uint32_t store_threads;
+    bool store_priority;
     bool refresh_transactions;
+    uint32_t upload_kilobytes_per_second;
+    bool compact_filters;
 
     /// Helpers.
     asio::duration block_latency() const;
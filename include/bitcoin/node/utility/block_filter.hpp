@@ -0,0 +1,54 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_BLOCK_FILTER_HPP
+#define LIBBITCOIN_NODE_BLOCK_FILTER_HPP
+
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// BIP158 basic block filter (Golomb-coded set) functions, thread safe.
+class BCN_API block_filter
+{
+public:
+    /// BIP158 basic filter type and parameters.
+    static const uint8_t basic_type;
+    static const uint8_t golomb_bits;
+    static const uint64_t inverse_rate;
+
+    /// Compute the serialized basic filter of a block.
+    /// False if any non-coinbase input is missing its previous output.
+    static bool compute(data_chunk& out_filter, const chain::block& block);
+
+    /// The filter header committing to the filter and the previous header.
+    static hash_digest to_header(const data_chunk& filter,
+        const hash_digest& previous_header);
+
+    /// The element may be in the filter of the block.
+    static bool contains(const data_chunk& filter,
+        const hash_digest& block_hash, const data_slice& element);
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
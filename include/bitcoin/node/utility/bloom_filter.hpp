@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_BLOOM_FILTER_HPP
+#define LIBBITCOIN_NODE_BLOOM_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// A BIP37 connection bloom filter, not thread safe.
+class BCN_API bloom_filter
+{
+public:
+    typedef std::shared_ptr<bloom_filter> ptr;
+    typedef std::vector<bool> matches;
+
+    /// BIP37 filter update modes (filterload flags).
+    enum update : uint8_t
+    {
+        update_none = 0,
+        update_all = 1,
+        update_p2pubkey_only = 2
+    };
+
+    /// BIP37 limits.
+    static const size_t max_filter_bytes;
+    static const size_t max_hash_functions;
+    static const size_t max_element_bytes;
+
+    /// The BIP37 MurmurHash3 (x86_32) of the data.
+    static uint32_t murmur3(const data_slice& data, uint32_t seed);
+
+    /// Construct from filterload message values.
+    bloom_filter(const data_chunk& data, uint32_t hash_functions,
+        uint32_t tweak, uint8_t flags);
+
+    /// The filter parameters are within BIP37 limits.
+    bool is_valid() const;
+
+    /// Add the element to the filter.
+    void insert(const data_slice& element);
+
+    /// The element may be in the filter.
+    bool contains(const data_slice& element) const;
+
+    /// Test all transactions of the block in one ordered pass, returning
+    /// the match set by position. The filter is updated as flagged.
+    matches match(const chain::block& block);
+
+    /// Build the BIP37 partial merkle block for the match set.
+    static message::merkle_block::ptr to_merkle_block(
+        const chain::block& block, const matches& matched);
+
+protected:
+    // Compute the bit index of each hash function for the element.
+    void indexes(uint32_t* out, const data_slice& element) const;
+
+    // Test the transaction and update the filter, true if matched.
+    bool match(const chain::transaction& tx, const hash_digest& hash);
+
+private:
+    data_chunk data_;
+    std::vector<uint32_t> seeds_;
+    const uint32_t hash_functions_;
+    const uint8_t flags_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -42,17 +42,22 @@ public:
     /// Push an entry at back, verify the height is increasing.
     void push_back(hash_digest&& hash, size_t height);
 
-    /// Pop an entry if exists at back, verify the height.
-    void pop_back(const hash_digest& hash, size_t height);
+    /// Remove all entries above the height, return the number removed.
+    size_t truncate(size_t fork_height);
 
     /// Push an entry at front, verify the height is decreasing.
     void push_front(hash_digest&& hash, size_t height);
 
+    /// Insert an entry in height order, false if the height exists.
+    bool insert(hash_digest&& hash, size_t height);
+
     /// Pop an entry from front, null/zero if empty.
     config::checkpoint pop_front();
 
-    /// Remove and return a fraction of the list, up to a limit.
-    checks extract(size_t divisor, size_t limit);
+    /// Remove and return a fraction of the list, up to a limit, excluding
+    /// entries above the maximum height.
+    checks extract(size_t divisor, size_t limit,
+        size_t maximum_height=max_size_t);
 
 protected:
     // Overflow safe iteration step.
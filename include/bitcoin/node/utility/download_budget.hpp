@@ -0,0 +1,73 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_DOWNLOAD_BUDGET_HPP
+#define LIBBITCOIN_NODE_DOWNLOAD_BUDGET_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Node-wide byte budget for requested and buffered blocks, thread safe.
+/// Credit is drawn at the estimated block size when a block is requested and
+/// refunded when it is imported (or its request is abandoned).
+class BCN_API download_budget
+{
+public:
+    /// Construct a budget, zero bytes is unlimited.
+    download_budget(uint64_t bytes, size_t initial_estimate);
+
+    /// Draw credit for up to the number of blocks, returning the number
+    /// granted and the credit drawn. One block is always granted when no
+    /// credit is outstanding, so that a block larger than the budget
+    /// cannot stall the download.
+    size_t draw(size_t blocks, uint64_t& out_bytes);
+
+    /// Return previously-drawn credit.
+    void refund(uint64_t bytes);
+
+    /// Update the block size estimate with the size of an imported block.
+    void record(size_t block_size);
+
+    /// The current block size estimate.
+    size_t estimate() const;
+
+    /// The outstanding credit.
+    uint64_t outstanding() const;
+
+    /// The ratio of outstanding credit to the budget, zero if unlimited.
+    double utilization() const;
+
+private:
+    // This is thread safe.
+    const uint64_t capacity_;
+
+    // Protected by mutex.
+    uint64_t outstanding_;
+    double estimate_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_FILTER_INDEX_HPP
+#define LIBBITCOIN_NODE_FILTER_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Persistent index of BIP158 basic filters by height, thread safe.
+/// The index is contiguous from genesis, filters are appended to the file
+/// as blocks are confirmed and truncated on reorganization. The index is
+/// unavailable while it is not contiguous with the confirmed chain, including
+/// from start until it has caught up with the confirmed chain.
+class BCN_API filter_index
+{
+public:
+    /// Construct an index persisted in the given file.
+    filter_index(const path& file);
+
+    /// Load the index from its file, creating the file if missing.
+    /// The index is unavailable until caught up with the confirmed chain.
+    bool start();
+
+    /// The number of indexed blocks (top indexed height plus one).
+    size_t size() const;
+
+    /// True once caught up and unless the last reorganization failed to
+    /// extend the index. Queries fail while the index is unavailable.
+    bool available() const;
+
+    /// Get the indexed block hash at the height, regardless of availability.
+    bool get_block_hash(hash_digest& out_hash, size_t height) const;
+
+    /// Index the confirmed block at the height, replacing any block indexed
+    /// at or above it. The block is not reindexed if already indexed at the
+    /// height. The index is available once it reaches the top height. False
+    /// if the block is not the child of the indexed block below it or its
+    /// filter is not computable or writable.
+    bool catch_up(const chain::block& block, size_t height,
+        size_t top_height);
+
+    /// Index the blocks above the fork height, replacing any above it.
+    /// False if the fork point is not indexed or a filter is not computable
+    /// or writable, in which case the index is unavailable until a
+    /// subsequent reorganization succeeds.
+    bool reorganize(size_t fork_height, const block_const_ptr_list& incoming);
+
+    /// Get the height of the indexed block hash.
+    bool get_height(size_t& out_height, const hash_digest& block_hash) const;
+
+    /// Get the block hash, filter hash and filter header at the height.
+    bool get_hashes(hash_digest& out_block_hash, hash_digest& out_filter_hash,
+        hash_digest& out_filter_header, size_t height) const;
+
+    /// Read the filter at the height from the file.
+    bool get_filter(data_chunk& out_filter, size_t height) const;
+
+private:
+    struct entry
+    {
+        hash_digest block_hash;
+        hash_digest filter_hash;
+        hash_digest filter_header;
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    bool open();
+    void close();
+    bool push(const chain::block& block);
+    void pop_above(size_t height);
+
+    // This is thread safe.
+    const path file_;
+
+    // Protected by mutex.
+    bool available_;
+    uint64_t end_;
+    std::vector<entry> entries_;
+    std::unordered_map<hash_digest, size_t> heights_;
+    std::unique_ptr<bc::ofstream> writer_;
+    mutable upgrade_mutex mutex_;
+
+    // Protected by reader mutex, reads are otherwise under shared lock.
+    std::unique_ptr<bc::ifstream> reader_;
+    mutable upgrade_mutex reader_mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_ORPHAN_POOL_HPP
+#define LIBBITCOIN_NODE_ORPHAN_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Memory-bounded pool of orphan transactions, thread safe.
+/// Orphans are indexed by missing previous transaction and evicted by age
+/// and then (oldest first) by total size.
+class BCN_API orphan_pool
+{
+public:
+    /// The largest transaction retained as an orphan.
+    static const size_t max_orphan_bytes;
+
+    /// Construct an empty pool.
+    orphan_pool(size_t maximum_bytes, uint32_t expiry_seconds);
+
+    /// Store an orphan with populated previous outputs, false if rejected.
+    bool store(transaction_const_ptr tx);
+
+    /// Remove and return orphans for which the parent was the last missing
+    /// previous transaction, in arrival order.
+    transaction_const_ptr_list resolve(const hash_digest& parent);
+
+    /// Remove the orphan (if stored).
+    void remove(const hash_digest& hash);
+
+    /// The number of stored orphans.
+    size_t size() const;
+
+    /// The total serialized size of stored orphans.
+    size_t bytes() const;
+
+protected:
+    typedef std::list<hash_digest> arrival_list;
+
+    struct orphan
+    {
+        transaction_const_ptr tx;
+        hash_list missing;
+        asio::time_point expiry;
+        arrival_list::iterator arrival;
+        size_t size;
+    };
+
+    // Remove the orphan and its index entries.
+    void erase(const hash_digest& hash);
+
+    // Evict expired orphans and then the oldest over the size limit.
+    void evict(const asio::time_point& now);
+
+private:
+    typedef std::unordered_map<hash_digest, orphan> orphan_map;
+    typedef std::unordered_multimap<hash_digest, hash_digest> parent_map;
+
+    // These are thread safe.
+    const size_t maximum_bytes_;
+    const asio::duration expiry_;
+
+    // Protected by mutex.
+    size_t bytes_;
+    orphan_map orphans_;
+    parent_map parents_;
+    arrival_list arrivals_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_OUTBOUND_SCALER_HPP
+#define LIBBITCOIN_NODE_OUTBOUND_SCALER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Node-wide outbound connection target, thread safe.
+/// While syncing the target grows as long as each increase raises aggregate
+/// block throughput and the store is not the bottleneck. Once current the
+/// target returns to the steady state count. Connection attempts above the
+/// target are parked and surplus channels are stopped.
+class BCN_API outbound_scaler
+{
+public:
+    typedef handle0 admit_handler;
+
+    /// Construct a scaler, the target starts at the steady state count.
+    outbound_scaler(size_t steady, size_t ceiling, uint32_t interval_seconds);
+
+    /// The maximum outbound connection target.
+    size_t ceiling() const;
+
+    /// The current outbound connection target.
+    size_t target() const;
+
+    /// The number of connected outbound channels.
+    size_t connected() const;
+
+    /// Invoke the handler once a connection is allowed under the target.
+    void admit(admit_handler handler);
+
+    /// Register a connected channel, false if it exceeds the target.
+    bool attach(network::channel::ptr channel);
+
+    /// Sample aggregate block rate and store discount ratio, adjusting the
+    /// target at most once per interval.
+    void update(double rate, double ratio, bool syncing);
+
+    /// Release parked attempts with service_stopped.
+    void stop();
+
+protected:
+    // Compute the next target from the sample (call under lock).
+    size_t next_target(double rate, double ratio, bool syncing);
+
+    // Remove the channel when it stops.
+    void handle_stop(const code& ec, uint64_t nonce);
+
+private:
+    typedef std::list<network::channel::ptr> channels;
+
+    // These are thread safe.
+    const size_t steady_;
+    const size_t ceiling_;
+    const asio::duration interval_;
+
+    // Protected by mutex.
+    bool stopped_;
+    bool growing_;
+    size_t target_;
+    double previous_rate_;
+    asio::time_point updated_;
+    channels channels_;
+    std::vector<admit_handler> parked_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
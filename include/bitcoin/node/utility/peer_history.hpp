@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_PEER_HISTORY_HPP
+#define LIBBITCOIN_NODE_PEER_HISTORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Persistent block download performance by peer address, thread safe.
+/// Records survive channel stop and node restart so that outbound selection
+/// can prefer peers that were historically fast.
+class BCN_API peer_history
+{
+public:
+    struct entry
+    {
+        /// Smoothed block download rate in events per second.
+        double rate;
+
+        /// Smoothed block request latency in milliseconds.
+        uint32_t latency;
+
+        /// The number of times the peer was dropped as a stalled slot.
+        uint32_t stalls;
+
+        /// The error code value of the most recent disconnect.
+        int32_t reason;
+    };
+
+    /// Construct a history persisted in the given file.
+    peer_history(const path& file, size_t capacity);
+
+    /// Load the history from its file, a missing file is empty.
+    bool load();
+
+    /// Replace the file with the current history.
+    bool save() const;
+
+    /// Merge a channel's measurements into the peer's history.
+    void record(const config::authority& peer, double rate,
+        uint32_t latency_milliseconds, bool stalled, const code& reason);
+
+    /// Get the history of the peer, false if unknown.
+    bool find(entry& out_entry, const config::authority& peer) const;
+
+    /// The selection score of the peer, zero if unknown.
+    double score(const config::authority& peer) const;
+
+    /// The number of peers with history.
+    size_t size() const;
+
+private:
+    typedef std::unordered_map<std::string, entry> entries;
+
+    static double to_score(const entry& value);
+
+    // Remove the lowest scoring entry (call under lock).
+    void evict();
+
+    // These are thread safe.
+    const path file_;
+    const size_t capacity_;
+
+    // Protected by mutex.
+    entries entries_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
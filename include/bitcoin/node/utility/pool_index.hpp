@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_POOL_INDEX_HPP
+#define LIBBITCOIN_NODE_POOL_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Node-wide index of pool transaction hashes by fee rate, thread safe.
+/// Pages are read in descending fee rate order from a cursor, so that a peer
+/// fee filter terminates the read instead of filtering a scan of the pool.
+class BCN_API pool_index
+{
+public:
+    /// A fee rate (satoshis per kilobyte) and hash position in the index.
+    typedef std::pair<uint64_t, hash_digest> cursor;
+
+    /// The cursor preceding all entries.
+    static const cursor first;
+
+    /// The fee rate of the transaction in satoshis per kilobyte.
+    static uint64_t fee_rate(const chain::transaction& tx);
+
+    /// The fee rate of the fees over the size in satoshis per kilobyte.
+    static uint64_t fee_rate(uint64_t fees, size_t size);
+
+    /// Construct an index, the lowest fee rate entries are evicted when full.
+    pool_index(size_t maximum_entries, size_t maximum_streams);
+
+    /// Add or update the transaction hash at the fee rate.
+    void insert(const hash_digest& hash, uint64_t rate);
+
+    /// Remove the transaction hash (if present).
+    void remove(const hash_digest& hash);
+
+    /// The current sequence, read before reading the pool.
+    uint64_t sequence() const;
+
+    /// Mark the indexed hashes of a page of the pool as pooled, and return
+    /// the hashes of the page that are not indexed.
+    hash_list synchronize(const hash_list& pooled);
+
+    /// Remove hashes neither inserted nor marked as pooled since the
+    /// sequence, and return the number removed.
+    size_t sweep(uint64_t sequence);
+
+    /// The number of indexed transactions.
+    size_t size() const;
+
+    /// Read up to limit hashes at or above the fee rate, following the
+    /// cursor, and return the cursor of the last hash read.
+    cursor page(hash_list& out, const cursor& after, uint64_t minimum_rate,
+        size_t limit) const;
+
+    /// Claim one of the limited concurrent mempool streams.
+    bool open_stream();
+
+    /// Release a claimed mempool stream.
+    void close_stream();
+
+private:
+    // Add the entry, evicting the lowest fee rate if full (call under lock).
+    void emplace(const hash_digest& hash, uint64_t rate);
+
+    // Descending fee rate, then ascending hash.
+    struct descending
+    {
+        bool operator()(const cursor& left, const cursor& right) const
+        {
+            return left.first > right.first ||
+                (left.first == right.first && left.second < right.second);
+        }
+    };
+
+    typedef std::set<cursor, descending> rates;
+    // The fee rate and the sequence of the last insert or pool mark.
+    typedef std::pair<uint64_t, uint64_t> position;
+    typedef std::unordered_map<hash_digest, position> hashes;
+
+    // Thread safe.
+    const size_t maximum_entries_;
+    const size_t maximum_streams_;
+
+    // Protected by mutex.
+    size_t streams_;
+    uint64_t sequence_;
+    rates rates_;
+    hashes hashes_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_RELAY_BUCKETS_HPP
+#define LIBBITCOIN_NODE_RELAY_BUCKETS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Node-wide transaction relay fan-out by quantized fee rate, thread safe.
+/// Each channel subscribes at the bucket of its fee filter, and a transaction
+/// is delivered only to the buckets at or below its own fee rate bucket. Only
+/// subscribers sharing the transaction bucket compare the exact fee rate.
+class BCN_API relay_buckets
+{
+public:
+    typedef std::function<void(transaction_const_ptr, uint64_t)>
+        relay_handler;
+
+    /// The highest bucket with lower bound not above the fee rate.
+    static size_t to_bucket(uint64_t rate);
+
+    /// Construct an empty subscriber set.
+    relay_buckets();
+
+    /// Subscribe (or move) the channel at its minimum fee rate (per kB).
+    void subscribe(uint64_t channel, uint64_t minimum_rate,
+        relay_handler handler);
+
+    /// Move the channel subscription to a new minimum fee rate (per kB),
+    /// false if the channel is not subscribed (none is created).
+    bool update(uint64_t channel, uint64_t minimum_rate);
+
+    /// Drop the channel subscription (if any).
+    void unsubscribe(uint64_t channel);
+
+    /// Deliver the transaction and its fee rate (per kB) to subscribers
+    /// accepting the fee rate.
+    void relay(transaction_const_ptr tx, uint64_t rate);
+
+    /// Drop all subscriptions.
+    void stop();
+
+    /// The number of subscribed channels.
+    size_t size() const;
+
+private:
+    struct subscriber
+    {
+        uint64_t minimum_rate;
+        relay_handler handler;
+    };
+
+    typedef std::unordered_map<uint64_t, subscriber> subscribers;
+    typedef std::unordered_map<uint64_t, size_t> channel_buckets;
+
+    // Protected by mutex.
+    std::vector<subscribers> buckets_;
+    channel_buckets channels_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -23,6 +23,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 #include <boost/bimap.hpp>
 #include <boost/bimap/set_of.hpp>
@@ -53,12 +54,22 @@ public:
     /// Assign the reservation to a channel.
     void start();
 
-    /// Unassign the reservation from a channel and reset.
-    void stop();
+    /// Unassign the reservation from the channel and reset, unless the
+    /// reservation has since been assigned to another channel.
+    void stop(uint64_t channel);
 
     /// True if not associated with a channel.
     bool stopped() const;
 
+    /// Set the channel and handler invoked when the reservation gains hashes.
+    void set_waker(uint64_t channel, result_handler handler);
+
+    /// The nonce of the channel set with the waker, zero if none.
+    uint64_t channel() const;
+
+    /// Invoke the waker, if set and no wakeup is pending a request.
+    void wake();
+
     /// The sequential identifier of this reservation.
     size_t slot() const;
 
@@ -83,12 +94,15 @@ public:
     // Hash methods.
     //-------------------------------------------------------------------------
 
-    /// True if there are currently no hashes.
+    /// True if there are currently no hashes, reserved or expedited.
     bool empty() const;
 
-    /// The number of outstanding blocks.
+    /// The number of outstanding blocks, reserved or expedited.
     size_t size() const;
 
+    /// The number of requested blocks not yet imported, including expedited.
+    size_t requested() const;
+
     /// Add the block hash to the reservation.
     void insert(config::checkpoint&& check);
 
@@ -98,6 +112,29 @@ public:
     // Get the height of the block hash, remove and return true if it is found.
     bool find_height_and_erase(const hash_digest& hash, size_t& out_height);
 
+    /// True if the reservation holds the block hash at the height, whether
+    /// reserved or expedited.
+    bool contains(size_t height) const;
+
+    /// Remove the block hash (reserved or expedited) at the height so that it
+    /// may be expedited by another reservation. Its late arrival here is then
+    /// ignored.
+    bool release(size_t height, config::checkpoint& out_check);
+
+    /// True if the hash was released from this reservation, remove it.
+    bool find_released_and_erase(const hash_digest& hash);
+
+    /// Add a block hash to be requested ahead of others, outside the budget.
+    void expedite(config::checkpoint&& check);
+
+    /// Remove an expedited block hash, true if found. Its late arrival is
+    /// then ignored.
+    bool withdraw(const hash_digest& hash);
+
+    /// Remove all block hashes above the fork height, returning the credit of
+    /// any requested. Their late arrival is then ignored.
+    size_t invalidate(size_t fork_height);
+
     /// Add to the blockchain, with height determined by the reservation.
     code import(blockchain::safe_chain& chain, block_const_ptr block,
         size_t height);
@@ -108,6 +145,10 @@ public:
 protected:
     typedef std::chrono::high_resolution_clock::time_point clock_point;
 
+    // Stop for partition, retaining the waker and credit of the channel, with
+    // conditional locking of the reservation table.
+    void stop(bool lock);
+
     // Accessor for testability.
     bool pending() const;
 
@@ -129,6 +170,15 @@ protected:
     // Update rate history to reflect an additional block of the given size.
     void update_history(size_t events, const asio::microseconds& database);
 
+    // Credit methods.
+    //-------------------------------------------------------------------------
+
+    // Return the budget credit of an imported block, if it was requested.
+    void settle(size_t height);
+
+    // Return all outstanding budget credit, abandoning requests.
+    void refund();
+
 private:
     typedef struct
     {
@@ -146,6 +196,15 @@ private:
 
     // Protected by hash mutex.
     hash_heights heights_;
+    hash_heights urgent_;
+    std::unordered_set<hash_digest> released_;
+    std::unordered_set<size_t> expedited_;
+    bool urgent_pending_;
+    uint64_t channel_;
+    size_t boundary_;
+    size_t credits_;
+    uint64_t drawn_;
+    result_handler waker_;
     mutable upgrade_mutex hash_mutex_;
 
     // Protected by history mutex.
@@ -155,6 +214,7 @@ private:
     // Thread safe.
     std::atomic<bool> stopped_;
     std::atomic<bool> pending_;
+    std::atomic<bool> woken_;
     reservations& reservations_;
     const size_t slot_;
     const float maximum_deviation_;
@@ -24,11 +24,13 @@
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/node/define.hpp>
 #include <bitcoin/node/settings.hpp>
 #include <bitcoin/node/utility/check_list.hpp>
+#include <bitcoin/node/utility/download_budget.hpp>
 #include <bitcoin/node/utility/performance.hpp>
 #include <bitcoin/node/utility/reservation.hpp>
 #include <bitcoin/node/utility/statistics.hpp>
@@ -44,12 +46,14 @@ public:
 
     /// Construct an empty table of reservations.
     reservations(size_t minimum_peer_count, float maximum_deviation,
-        uint32_t block_latency_seconds);
+        uint32_t block_latency_seconds, uint32_t download_budget_megabytes,
+        uint32_t download_lookahead_blocks);
 
-    /// Pop header hash to back (if hash at back), verify the height.
-    void pop_back( chain::header& header, size_t height);
+    /// Remove hashes above the fork height from the queue and all rows.
+    void invalidate(size_t fork_height);
 
     /// Push header hash to back, verify the height is increasing.
+    /// A recently-announced hash is instead raced to its announcer.
     void push_back( chain::header& header, size_t height);
 
     /// Push header hash to front, verify the height is decreasing.
@@ -61,12 +65,42 @@ public:
     /// Populate a starved row by taking half of the hashes from a weak row.
     void populate(reservation::ptr minimal);
 
+    /// Reserve unreserved hashes to idle rows, waking those that gain work.
+    void distribute();
+
+    /// Move the block at the validation frontier to the fastest other row if
+    /// the frontier has not advanced within the timeout.
+    void expedite(size_t height, const asio::duration& timeout);
+
+    /// Advance the reservable height window to follow validation.
+    void slide(size_t validated_height);
+
+    /// Record a header announced by the channel, if the queue is shallow.
+    void announce(const hash_digest& hash, uint64_t channel);
+
+    /// Claim an expedited block for import by the slot, false if a racing
+    /// slot has claimed it. The block is withdrawn from other racing slots.
+    bool claim(const hash_digest& hash, size_t slot);
+
+    /// Return an expedited hash abandoned by a stopped slot, unless another
+    /// slot remains in its race.
+    void abandon(const hash_digest& hash, size_t height, bool lock=true);
+
     /// Check a partition for expiration.
     bool expired(reservation::const_ptr partition) const;
 
     /// The total number of pending block hashes.
     size_t size() const;
 
+    /// The aggregate block import rate of active rows.
+    double rate() const;
+
+    /// The average ratio of database time to total time of active rows.
+    double ratio() const;
+
+    /// The node-wide byte budget for requested blocks.
+    download_budget& budget();
+
 protected:
     // Obtain a copy of the reservations table.
     reservation::list table() const;
@@ -77,6 +111,9 @@ protected:
     // Move half of the maximal reservation to the specified reservation.
     bool partition(reservation::ptr minimal);
 
+    // Expedite an announced hash to its announcer and the fastest other slot.
+    bool race(const hash_digest& hash, size_t height);
+
     // Check a partition for expiration, with conditional locking.
     bool expired(reservation::const_ptr partition, bool lock) const;
 
@@ -92,18 +129,46 @@ protected:
     // The number of hashes available for reservation.
     size_t unreserved() const;
 
+    // The greatest reservable height, unguarded.
+    size_t ceiling() const;
+
 private:
+    typedef struct
+    {
+        uint64_t channel;
+        asio::time_point time;
+    } announcement;
+
+    typedef struct
+    {
+        size_t height;
+        size_t racers;
+        bool claimed;
+        asio::time_point announced;
+        reservation::list rows;
+    } download_race;
+
+    typedef std::unordered_map<hash_digest, announcement> announcements;
+    typedef std::unordered_map<hash_digest, download_race> races;
+
     ////void dump_table(size_t slot) const;
 
     // Thread safe.
     check_list hashes_;
+    download_budget budget_;
     const size_t max_request_;
     const size_t minimum_peer_count_;
     const uint32_t block_latency_seconds_;
     const float maximum_deviation_;
+    const size_t lookahead_;
 
     // Protected by mutex.
     bool initialized_;
+    size_t frontier_;
+    size_t validated_;
+    asio::time_point frontier_since_;
+    announcements announced_;
+    races races_;
     reservation::list table_;
     mutable upgrade_mutex mutex_;
 };
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_ROLLING_FILTER_HPP
+#define LIBBITCOIN_NODE_ROLLING_FILTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Rolling bloom filter of recently-inserted hashes, thread safe.
+/// The filter holds two generations of up to half of the capacity each, so
+/// the most recent capacity / 2 to capacity hashes are always contained.
+class BCN_API rolling_filter
+{
+public:
+    /// Construct an empty filter with the given false positive rate.
+    rolling_filter(size_t capacity, double false_positive_rate);
+
+    /// Add the hash to the filter.
+    void insert(const hash_digest& hash);
+
+    /// The hash may have been inserted (recently).
+    bool contains(const hash_digest& hash) const;
+
+    /// Remove all hashes from the filter.
+    void clear();
+
+protected:
+    // Compute the bit index of each hash function for the hash.
+    void indexes(uint32_t* out, const hash_digest& hash) const;
+
+private:
+    typedef std::vector<uint64_t> generation;
+
+    // These are thread safe.
+    const size_t generation_size_;
+    const uint32_t bit_count_;
+    std::vector<uint32_t> seeds_;
+
+    // Protected by mutex.
+    size_t count_;
+    generation current_;
+    generation previous_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
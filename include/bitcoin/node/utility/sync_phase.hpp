@@ -0,0 +1,79 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_SYNC_PHASE_HPP
+#define LIBBITCOIN_NODE_SYNC_PHASE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Node-wide block sync phase, thread safe.
+/// Channels connected while syncing are attached block download protocols
+/// only. These are held here and upgraded in place, by attaching the relay
+/// protocols, once the chain is current.
+class BCN_API sync_phase
+{
+public:
+    typedef std::function<void(network::channel::ptr)> upgrade_handler;
+
+    /// Construct in the syncing phase.
+    sync_phase();
+
+    /// True if the chain is not current.
+    bool syncing() const;
+
+    /// Hold the channel for upgrade, false if the chain is current.
+    bool defer(network::channel::ptr channel, upgrade_handler handler);
+
+    /// Set the phase, upgrading all held channels once current.
+    void update(bool syncing);
+
+    /// Drop held channels, preventing further deferral.
+    void stop();
+
+protected:
+    // Remove the channel when it stops.
+    void handle_stop(const code& ec, uint64_t nonce);
+
+private:
+    struct deferral
+    {
+        network::channel::ptr channel;
+        upgrade_handler handler;
+    };
+
+    typedef std::list<deferral> deferrals;
+
+    // Protected by mutex.
+    bool stopped_;
+    bool syncing_;
+    deferrals deferred_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_TIMING_WHEEL_HPP
+#define LIBBITCOIN_NODE_TIMING_WHEEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Node-wide timing wheel for coarse keyed deadlines, thread safe.
+/// Scheduling, rescheduling and canceling a deadline are constant time, and
+/// a single timer advances the wheel by one tick while deadlines are pending.
+class BCN_API timing_wheel
+{
+public:
+    typedef handle0 expiry_handler;
+
+    /// Construct a wheel of the given tick duration and number of buckets.
+    timing_wheel(threadpool& pool, uint32_t tick_milliseconds,
+        size_t buckets);
+
+    /// Schedule the keyed deadline, replacing any pending for the key.
+    void schedule(uint64_t key, const asio::duration& delay,
+        expiry_handler handler);
+
+    /// Cancel the keyed deadline, its handler is not invoked.
+    void cancel(uint64_t key);
+
+    /// The number of pending deadlines.
+    size_t size() const;
+
+    /// Cancel the timer and drop all pending deadlines.
+    void stop();
+
+protected:
+    // Remove the keyed deadline (call under lock).
+    void remove(uint64_t key);
+
+    // Start the tick timer if not running (call under lock).
+    void start_timer();
+
+    // Advance the wheel one tick, invoking expired handlers.
+    void handle_timer(const code& ec);
+
+private:
+    struct entry
+    {
+        uint64_t key;
+        size_t rounds;
+        expiry_handler handler;
+    };
+
+    typedef std::list<entry> bucket;
+
+    struct position
+    {
+        size_t index;
+        bucket::iterator it;
+    };
+
+    typedef std::unordered_map<uint64_t, position> positions;
+
+    // These are thread safe.
+    threadpool& pool_;
+    const asio::duration tick_;
+
+    // Protected by mutex.
+    bool stopped_;
+    bool running_;
+    size_t cursor_;
+    deadline::ptr timer_;
+    std::vector<bucket> buckets_;
+    positions positions_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_TRANSACTION_REQUESTS_HPP
+#define LIBBITCOIN_NODE_TRANSACTION_REQUESTS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Node-wide tracker of in-flight transaction requests, thread safe.
+/// Each announced transaction is requested from one announcer at a time.
+/// A request that times out (or is not found) falls back to the best other
+/// announcer, preferring outbound and then lower-latency channels.
+/// Each channel may hold a bounded number of tracked announcements.
+class BCN_API transaction_requests
+{
+public:
+    /// Construct a tracker, inbound announcements wait for the delay.
+    transaction_requests(uint32_t timeout_seconds,
+        uint32_t inbound_delay_seconds);
+
+    /// Register a channel as an announcer.
+    void add(uint64_t channel, bool outbound);
+
+    /// Drop the channel, its requests fall back to other announcers.
+    void remove(uint64_t channel);
+
+    /// Record an announcement, true if the channel should request it now.
+    /// Announcements beyond the channel's limit are not tracked (false).
+    bool announce(uint64_t channel, const hash_digest& hash);
+
+    /// The transaction was received (whether or not it was accepted).
+    void complete(uint64_t channel, const hash_digest& hash);
+
+    /// The channel does not have the transaction, fall back immediately.
+    void not_found(uint64_t channel, const hash_digest& hash);
+
+    /// Expire requests and obtain those now assigned to the channel.
+    hash_list reassigned(uint64_t channel);
+
+    /// The number of tracked transactions.
+    size_t size() const;
+
+protected:
+    struct request
+    {
+        bool assigned;
+        uint64_t channel;
+        asio::time_point requested;
+        asio::time_point deadline;
+        std::vector<uint64_t> announcers;
+    };
+
+    struct announcer
+    {
+        bool outbound;
+        bool measured;
+        asio::duration latency;
+        hash_list assigned;
+        std::unordered_set<hash_digest> announced;
+    };
+
+    typedef std::unordered_map<hash_digest, request> request_map;
+    typedef std::pair<asio::time_point, hash_digest> scheduled;
+
+    // Assign the request to its best announcer, false if none remain.
+    bool assign(const hash_digest& hash, request& entry,
+        const asio::time_point& now);
+
+    // Reassign expired requests.
+    void expire(const asio::time_point& now);
+
+    // Move the deadline of the request.
+    void reschedule(const hash_digest& hash, request& entry,
+        const asio::time_point& time);
+
+    // Remove the announcer from the request.
+    void withdraw(const hash_digest& hash, request& entry, uint64_t channel);
+
+    // Remove the request and its index entries.
+    void drop(request_map::iterator it);
+
+private:
+    typedef std::unordered_map<uint64_t, announcer> announcer_map;
+    typedef std::set<scheduled> schedule;
+
+    // These are thread safe.
+    const asio::duration timeout_;
+    const asio::duration inbound_delay_;
+
+    // Protected by mutex.
+    asio::time_point expired_;
+    request_map requests_;
+    announcer_map announcers_;
+    schedule deadlines_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_NODE_UPLOAD_SCHEDULER_HPP
+#define LIBBITCOIN_NODE_UPLOAD_SCHEDULER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+/// Node-wide block upload scheduler, thread safe.
+/// Store reads are granted to channels in deficit round robin order, subject
+/// to a global byte rate limit. Recently-announced (tip) blocks are granted
+/// immediately so that they never wait behind a bulk upload.
+class BCN_API upload_scheduler
+{
+public:
+    typedef handle0 grant_handler;
+
+    /// Construct a scheduler, zero rate is unlimited.
+    upload_scheduler(threadpool& pool, uint32_t kilobytes_per_second);
+
+    /// Queue a block read for the channel, handler invoked when granted.
+    void enqueue(uint64_t channel, const hash_digest& hash,
+        grant_handler handler);
+
+    /// Release the grant for the hash and charge the bytes sent.
+    void complete(uint64_t channel, const hash_digest& hash, size_t bytes);
+
+    /// Drop the channel and any of its pending requests.
+    void remove(uint64_t channel);
+
+    /// Record a newly-announced block as a priority upload.
+    void announce(const hash_digest& hash);
+
+    /// Cancel the rate timer and drop all pending requests.
+    void stop();
+
+protected:
+    struct request
+    {
+        hash_digest hash;
+        grant_handler handler;
+    };
+
+    typedef std::deque<request> requests;
+
+    // True if the hash is a recently-announced block.
+    bool is_tip(const hash_digest& hash) const;
+
+    // Replenish the rate bucket for the elapsed time.
+    void refill();
+
+    // Grant requests in round robin order while budget remains.
+    void dispatch();
+
+    // Resume dispatch once the rate bucket has been replenished.
+    void handle_timer(const code& ec);
+
+private:
+    typedef std::unordered_map<uint64_t, requests> channel_requests;
+    typedef std::unordered_map<uint64_t, hash_digest> channel_grants;
+    typedef std::unordered_map<uint64_t, int64_t> channel_deficits;
+
+    // Thread safe.
+    threadpool& pool_;
+    const int64_t bytes_per_second_;
+
+    // Protected by mutex.
+    bool stopped_;
+    bool waiting_;
+    int64_t tokens_;
+    asio::time_point refilled_;
+    deadline::ptr timer_;
+    std::list<uint64_t> round_;
+    std::deque<hash_digest> tips_;
+    channel_requests pending_;
+    channel_grants granted_;
+    channel_deficits deficits_;
+    mutable upgrade_mutex mutex_;
+};
+
+} // namespace node
+} // namespace libbitcoin
+
+#endif
@@ -18,11 +18,12 @@
  */
 #include <bitcoin/node/full_node.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <utility>
-#include <boost/range/adaptor/reversed.hpp>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/node/configuration.hpp>
 #include <bitcoin/node/define.hpp>
@@ -37,16 +38,76 @@ using namespace bc::blockchain;
 using namespace bc::chain;
 using namespace bc::config;
 using namespace bc::network;
-using namespace boost::adaptors;
 using namespace std::placeholders;
 
+// Download performance is retained for up to this many peer addresses.
+static constexpr size_t maximum_history = 10000;
+
+// The outbound connection target is adjusted at most once in this period.
+static constexpr uint32_t scaling_interval_seconds = 30;
+
+// Block download deadlines are resolved to this tick, over this many buckets.
+static constexpr uint32_t deadline_tick_milliseconds = 500;
+static constexpr size_t deadline_buckets = 256;
+
+// The validation frontier is checked for a stalled block at this interval.
+// Channel deadlines are keyed by random nonce, so low keys are reserved.
+static constexpr uint32_t frontier_interval_seconds = 1;
+static constexpr uint64_t frontier_key = 0;
+
+// Header reindexations are distributed to download slots once per tick.
+static constexpr uint64_t distribute_key = 1;
+
+// The pool index is reconciled with the transaction pool at this interval.
+static constexpr uint32_t mempool_interval_seconds = 60;
+static constexpr uint64_t mempool_key = 2;
+
+// The outbound connection target is sampled at this interval, independent of
+// block arrival, so that a stalled download still adjusts it.
+static constexpr uint32_t scaling_sample_seconds = 5;
+static constexpr uint64_t scaling_key = 3;
+
+// A requested transaction not received in this time is requested elsewhere.
+static constexpr uint32_t transaction_timeout_seconds = 60;
+
+// Inbound announcements wait this long for an outbound announcer.
+static constexpr uint32_t inbound_delay_seconds = 2;
+
+// Orphan transactions are retained up to this total size and age.
+static constexpr size_t maximum_orphan_bytes = 5000000;
+static constexpr uint32_t orphan_expiry_seconds = 1200;
+
+// Recently rejected transaction hashes are filtered until the tip changes.
+static constexpr size_t rejected_capacity = 120000;
+static constexpr double rejected_false_positive_rate = 0.000001;
+
+// Pool transactions are indexed by fee rate for streaming mempool responses.
+static constexpr size_t maximum_mempool_entries = 300000;
+static constexpr size_t maximum_mempool_streams = 8;
+
     full_node::full_node( config::configuration *conf)
   : p2p(*((configuration *)conf)->network),
     reservations_(((configuration *)conf)->network->minimum_connections(),
         ((configuration *)conf)->node->maximum_deviation,
-        ((configuration *)conf)->node->block_latency_seconds),
-    chain_(thread_pool(), *((configuration *)conf)->chain, *((configuration *)conf)->database,
+        ((configuration *)conf)->node->block_latency_seconds,
+        ((configuration *)conf)->node->download_budget_megabytes,
+        ((configuration *)conf)->node->download_lookahead_blocks),
+    history_(((configuration *)conf)->network->hosts_file.parent_path() /
+        "history", maximum_history),
+    scaler_(((configuration *)conf)->network->outbound_connections,
+        ((configuration *)conf)->node->sync_outbound_connections,
+        scaling_interval_seconds),
+    deadlines_(thread_pool(), deadline_tick_milliseconds, deadline_buckets),
+    uploads_(thread_pool(),
+        ((configuration *)conf)->node->upload_kilobytes_per_second),
+    filters_(((configuration *)conf)->database->directory / "filters"),
+    requests_(transaction_timeout_seconds, inbound_delay_seconds),
+    orphans_(maximum_orphan_bytes, orphan_expiry_seconds),
+    rejected_(rejected_capacity, rejected_false_positive_rate),
+    mempool_(maximum_mempool_entries, maximum_mempool_streams),
+    chain_(store_pool_, *((configuration *)conf)->chain, *((configuration *)conf)->database,
         *((configuration *)conf)->bitcoin),
+    distributing_(false),
     protocol_maximum_(((configuration *)conf)->network->protocol_maximum),
     chain_settings_(*((configuration *)conf)->chain),
     node_settings_(*((configuration *)conf)->node)
@@ -69,6 +130,12 @@ void full_node::start(result_handler handler)
         return;
     }
 
+    // Header organization and block imports are posted to the store pool, so
+    // that store writes do not hold the network threads.
+    store_pool_.spawn(thread_ceiling(node_settings_.store_threads),
+        node_settings_.store_priority ? thread_priority::high :
+            thread_priority::normal);
+
     if (!chain_.start())
     {
         LOG_ERROR(LOG_NODE)
@@ -77,6 +144,11 @@ void full_node::start(result_handler handler)
         return;
     }
 
+    // Peer history is advisory, so a corrupt file does not prevent start.
+    if (!history_.load())
+        LOG_WARNING(LOG_NODE)
+            << "Failure loading peer history.";
+
     // This is invoked on the same thread.
     // Stopped is true and no network threads until after this call.
     p2p::start(handler);
@@ -126,6 +198,14 @@ void full_node::handle_running(const code& ec, result_handler handler)
     LOG_INFO(LOG_NODE)
         << "Top confirmed block height is (" << top_confirmed.height() << ").";
 
+    if (node_settings_.compact_filters && !start_filters())
+    {
+        LOG_ERROR(LOG_NODE)
+            << "The compact filter index is corrupt.";
+        handler(error::operation_failed);
+        return;
+    }
+
     checkpoint top_candidate;
     if (!chain_.get_top(top_candidate, true))
     {
@@ -143,6 +223,10 @@ void full_node::handle_running(const code& ec, result_handler handler)
         std::bind(&full_node::handle_reorganized,
             this, _1, _2, _3, _4));
 
+    subscribe_transactions(
+        std::bind(&full_node::handle_transaction,
+            this, _1, _2));
+
     set_top_header(top_candidate);
     const auto top_candidate_height = top_candidate.height();
 
@@ -176,11 +260,266 @@ void full_node::handle_running(const code& ec, result_handler handler)
         chain_.prime_validation(hash, next_validatable_height);
     }
 
+    // Channels are attached sync or relay protocols by chain staleness.
+    phase_.update(chain_.is_blocks_stale());
+
+    // Start following the validation frontier.
+    handle_frontier(error::success);
+
+    // Index the pool and start following it.
+    handle_mempool(error::success);
+
+    // Start scaling outbound connections to the block download rate.
+    handle_scaling(error::success);
+
     // This is invoked on a new thread.
     // This is the end of the derived run startup sequence.
     p2p::run(handler);
 }
 
+// Validation proceeds in height order, so a single missing block above the
+// top valid candidate blocks all that follow. If the frontier does not advance
+// within the block latency its block is requested from another channel.
+// The download window also follows the frontier.
+void full_node::handle_frontier(const code& ec)
+{
+    if (stopped() || ec == error::service_stopped)
+        return;
+
+    const auto validated = chain_.top_valid_candidate_state()->height();
+    reservations_.slide(validated);
+    reservations_.expedite(validated + 1u, node_settings_.block_latency());
+
+    const auto interval = asio::seconds(frontier_interval_seconds);
+    deadlines_.schedule(frontier_key, interval,
+        std::bind(&full_node::handle_frontier,
+            this, _1));
+}
+
+// Scale outbound connections to the aggregate block download rate.
+void full_node::handle_scaling(const code& ec)
+{
+    if (stopped() || ec == error::service_stopped)
+        return;
+
+    scaler_.update(reservations_.rate(), reservations_.ratio(),
+        chain_.is_blocks_stale());
+
+    const auto interval = asio::seconds(scaling_sample_seconds);
+    deadlines_.schedule(scaling_key, interval,
+        std::bind(&full_node::handle_scaling,
+            this, _1));
+}
+
+// Filters are indexed from genesis as blocks are confirmed, so an index that
+// does not reach the confirmed top is left idle (no backfill).
+// The index is caught up from the store on the store pool, and is unavailable
+// to peers until it reaches the confirmed chain.
+bool full_node::start_filters()
+{
+    if (!filters_.start())
+        return false;
+
+    store_pool_.service().post(
+        std::bind(&full_node::catch_up_filters,
+            this));
+
+    return true;
+}
+
+// The confirmed chain may grow or reorganize while catching up, so its top is
+// read for each block. A reorganization that forks below the index top
+// completes the index, otherwise catching up stops at the fork.
+void full_node::catch_up_filters()
+{
+    checkpoint top;
+    if (!chain_.get_top(top, false))
+        return;
+
+    // Find the highest indexed block on the confirmed chain.
+    auto height = std::min(filters_.size(), top.height() + 1u);
+    hash_digest indexed;
+    hash_digest confirmed;
+
+    while (height > 0u && !(filters_.get_block_hash(indexed, height - 1u) &&
+        chain_.get_block_hash(confirmed, height - 1u, false) &&
+        indexed == confirmed))
+        --height;
+
+    LOG_INFO(LOG_NODE)
+        << "Compact filter index catching up from (" << height << ") to ("
+        << top.height() << ").";
+
+    for (; !stopped() && chain_.get_top(top, false) && height <= top.height();
+        ++height)
+    {
+        block_const_ptr block;
+
+        // This is invoked on the same thread.
+        chain_.fetch_block(height, false,
+            [&](const code& ec, block_const_ptr result, size_t)
+            {
+                if (!ec)
+                    block = result;
+            });
+
+        if (!block || !populate_prevouts(*block) ||
+            !filters_.catch_up(*block, height, top.height()))
+            break;
+    }
+
+    if (filters_.available())
+        LOG_INFO(LOG_NODE)
+            << "Compact filter index caught up at (" << filters_.size() - 1u
+            << ").";
+    else if (!stopped())
+        LOG_WARNING(LOG_NODE)
+            << "Compact filter index not caught up at (" << height
+            << "), filters are unavailable to peers.";
+}
+
+// Stored blocks do not carry the previous outputs required by the filter, so
+// these are populated from the store as by block validation.
+bool full_node::populate_prevouts(const block& block)
+{
+    auto result = true;
+    const auto& txs = block.transactions();
+
+    const auto populate = [&](const code& ec, transaction_const_ptr previous,
+        const output_point& prevout)
+    {
+        if (ec || prevout.index() >= previous->outputs().size())
+            result = false;
+        else
+            prevout.metadata.cache = previous->outputs()[prevout.index()];
+    };
+
+    // The coinbase has no previous outputs.
+    for (auto tx = txs.begin() + (txs.empty() ? 0 : 1); tx != txs.end(); ++tx)
+    {
+        for (const auto& input: tx->inputs())
+        {
+            const auto& prevout = input.previous_output();
+
+            // This is invoked on the same thread.
+            chain_.fetch_transaction(prevout.hash(), true, false,
+                std::bind(populate, _1, _2, std::cref(prevout)));
+
+            if (!result)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Removals from the pool are not published, so the index is reconciled with
+// the pool periodically and when blocks return transactions to the pool. The
+// pool is read in pages, each marking its indexed transactions as pooled, and
+// the terminal (partial) page sweeps those not marked since the read began.
+void full_node::handle_mempool(const code& ec)
+{
+    if (stopped() || ec == error::service_stopped)
+        return;
+
+    chain_.fetch_mempool(maximum_mempool_entries, 0,
+        std::bind(&full_node::handle_fetch_mempool,
+            this, _1, _2, mempool_.sequence()));
+
+    const auto interval = asio::seconds(mempool_interval_seconds);
+    deadlines_.schedule(mempool_key, interval,
+        std::bind(&full_node::handle_mempool,
+            this, _1));
+}
+
+void full_node::handle_fetch_mempool(const code& ec, inventory_ptr page,
+    uint64_t sequence)
+{
+    if (stopped() || ec)
+        return;
+
+    hash_list pooled;
+    pooled.reserve(page->inventories().size());
+
+    for (const auto& inventory: page->inventories())
+        pooled.push_back(inventory.hash());
+
+    const auto unindexed = mempool_.synchronize(pooled);
+
+    if (!unindexed.empty())
+        store_pool_.service().post(
+            std::bind(&full_node::index_pooled,
+                this, unindexed));
+
+    if (pooled.size() < max_inventory)
+    {
+        const auto removed = mempool_.sweep(sequence);
+
+        LOG_DEBUG(LOG_NODE)
+            << "Indexed pool transactions (" << mempool_.size()
+            << "), removed (" << removed << ").";
+    }
+}
+
+// Pool transactions are read without populated previous outputs, so the fee
+// rate of a transaction not accepted by this node is computed by fetching its
+// previous outputs. Fetches are made in sequence on the store pool.
+void full_node::index_pooled(const hash_list& hashes)
+{
+    for (const auto& hash: hashes)
+    {
+        if (stopped())
+            return;
+
+        chain_.fetch_transaction(hash, false, false,
+            std::bind(&full_node::handle_fetch_pooled,
+                this, _1, _2, _3));
+    }
+}
+
+void full_node::handle_fetch_pooled(const code& ec, transaction_const_ptr tx,
+    size_t position)
+{
+    // The transaction may have been confirmed or dropped since the page read.
+    if (ec || position != database::transaction_result::unconfirmed ||
+        tx->inputs().empty())
+        return;
+
+    const auto fee = std::make_shared<pooled_fee>();
+    fee->tx = tx;
+    fee->value = 0;
+    fee->remaining = tx->inputs().size();
+    fee->missing = false;
+
+    for (const auto& input: tx->inputs())
+    {
+        const auto& prevout = input.previous_output();
+
+        chain_.fetch_transaction(prevout.hash(), false, false,
+            std::bind(&full_node::handle_fetch_previous,
+                this, _1, _2, prevout.index(), fee));
+    }
+}
+
+void full_node::handle_fetch_previous(const code& ec,
+    transaction_const_ptr previous, uint32_t index, pooled_fee_ptr fee)
+{
+    if (ec || index >= previous->outputs().size())
+        fee->missing = true;
+    else
+        fee->value += previous->outputs()[index].value();
+
+    if (--fee->remaining != 0 || fee->missing)
+        return;
+
+    const auto& tx = *fee->tx;
+    const auto fees = floor_subtract(fee->value.load(),
+        tx.total_output_value());
+
+    mempool_.insert(tx.hash(),
+        pool_index::fee_rate(fees, tx.serialized_size(false)));
+}
+
 // A typical reorganization consists of one incoming and zero outgoing blocks.
 bool full_node::handle_reindexed(code ec, size_t fork_height,
     header_const_ptr_list_const_ptr incoming,
@@ -201,22 +540,38 @@ bool full_node::handle_reindexed(code ec, size_t fork_height,
     if (!incoming || incoming->empty())
         return true;
 
-    // First pop height is highest outgoing.
-    auto height = fork_height + outgoing->size();
+    auto height = fork_height;
 
-    // Pop outgoing reservations from download queue (if at top), high first.
-    for (const auto header: reverse(*outgoing))
-        reservations_.pop_back(*header, height--);
+    // Remove outgoing hashes from the download queue and all reservations.
+    if (!outgoing->empty())
+        reservations_.invalidate(fork_height);
 
     // Push unpopulated incoming reservations (can't expect parent), low first.
     for (const auto header: *incoming)
         reservations_.push_back(*header, ++height);
 
+    // Wake only the idle download slots that gain hashes, on the next tick.
+    if (!distributing_.exchange(true))
+        deadlines_.schedule(distribute_key, asio::duration::zero(),
+            std::bind(&full_node::handle_distribute,
+                this, _1));
+
     // Top height will be: fork_height + incoming->size();
     set_top_header({ incoming->back()->hash(), height });
     return true;
 }
 
+// Reindexations after this reset are distributed on a subsequent tick.
+void full_node::handle_distribute(const code& ec)
+{
+    distributing_ = false;
+
+    if (stopped() || ec == error::service_stopped)
+        return;
+
+    reservations_.distribute();
+}
+
 // A typical reorganization consists of one incoming and zero outgoing blocks.
 bool full_node::handle_reorganized(code ec, size_t fork_height,
     block_const_ptr_list_const_ptr incoming,
@@ -244,11 +599,113 @@ bool full_node::handle_reorganized(code ec, size_t fork_height,
             << encode_hash(block->header().hash()) << "]";
     }
 
+    // New blocks are uploaded with priority over historical blocks.
+    for (const auto block: *incoming)
+        uploads_.announce(block->hash());
+
+    // Channels attached while syncing are upgraded once current.
+    phase_.update(chain_.is_blocks_stale());
+
+    // A rejected transaction may become valid under the new tip.
+    rejected_.clear();
+
+    // Transactions of outgoing blocks return to the pool, on the next tick.
+    if (!outgoing->empty())
+        deadlines_.schedule(mempool_key, asio::duration::zero(),
+            std::bind(&full_node::handle_mempool,
+                this, _1));
+
+    // Confirmed transactions are no longer orphans and may be parents.
+    for (const auto block: *incoming)
+    {
+        for (const auto& tx: block->transactions())
+        {
+            const auto hash = tx.hash();
+            mempool_.remove(hash);
+            orphans_.remove(hash);
+            organize_orphans(hash);
+        }
+    }
+
+    // Confirmed blocks carry the previous outputs required by the filter.
+    // Stored blocks do not, so a failed index is caught up on the next start.
+    if (node_settings_.compact_filters)
+    {
+        const auto available = filters_.available();
+
+        if (!filters_.reorganize(fork_height, *incoming))
+        {
+            if (available)
+                LOG_ERROR(LOG_NODE)
+                    << "Compact filter index not extended above ("
+                    << fork_height << "), filters are unavailable to peers.";
+        }
+        else if (!available)
+        {
+            LOG_INFO(LOG_NODE)
+                << "Compact filter index restored above (" << fork_height
+                << ").";
+        }
+    }
+
     const auto height = fork_height + incoming->size();
     set_top_block({ incoming->back()->hash(), height });
     return true;
 }
 
+// Orphans are organized once their last missing parent is accepted, and their
+// descendants in turn as each is accepted (topological order).
+bool full_node::handle_transaction(code ec, transaction_const_ptr tx)
+{
+    if (stopped() || ec == error::service_stopped)
+        return false;
+
+    if (ec)
+    {
+        LOG_ERROR(LOG_NODE)
+            << "Failure handling transaction: " << ec.message();
+        stop();
+        return false;
+    }
+
+    // Nothing to do here, a channel is stopping.
+    if (!tx)
+        return true;
+
+    // The fee rate is computed once for the index and all relay channels.
+    const auto rate = pool_index::fee_rate(*tx);
+    mempool_.insert(tx->hash(), rate);
+    relay_.relay(tx, rate);
+
+    organize_orphans(tx->hash());
+    return true;
+}
+
+void full_node::organize_orphans(const hash_digest& parent)
+{
+    for (const auto orphan: orphans_.resolve(parent))
+        chain_.organize(orphan,
+            std::bind(&full_node::handle_orphan,
+                this, _1, orphan));
+}
+
+void full_node::handle_orphan(const code& ec, transaction_const_ptr tx)
+{
+    if (stopped() || ec == error::service_stopped)
+        return;
+
+    // Another parent may have been missing from the original validation.
+    if (ec == error::orphan_transaction)
+    {
+        orphans_.store(tx);
+        return;
+    }
+
+    LOG_DEBUG(LOG_NODE)
+        << (ec ? "Dropped" : "Stored") << " orphan transaction ["
+        << encode_hash(tx->hash()) << "] " << ec.message();
+}
+
 // Specializations.
 // ----------------------------------------------------------------------------
 // Create derived sessions and override these to inject from derived node.
@@ -275,10 +732,32 @@ network::session_outbound::ptr full_node::attach_outbound_session()
 
 bool full_node::stop()
 {
+    // Drop pending uploads before the threadpool is stopped.
+    uploads_.stop();
+
+    // Release relay subscribers, which hold their channel protocols.
+    relay_.stop();
+
+    // Release parked outbound connection attempts.
+    scaler_.stop();
+
+    // Release channels held for relay protocols.
+    phase_.stop();
+
+    // Release pending block download deadlines, which hold their protocols.
+    deadlines_.stop();
+
     // Suspend new work last so we can use work to clear subscribers.
     const auto p2p_stop = p2p::stop();
     const auto chain_stop = chain_.stop();
 
+    // Release the threads of the node's own pools.
+    store_pool_.shutdown();
+
+    if (!history_.save())
+        LOG_WARNING(LOG_NODE)
+            << "Failed to save peer history.";
+
     if (!p2p_stop)
         LOG_ERROR(LOG_NODE)
             << "Failed to stop network.";
@@ -300,6 +779,8 @@ bool full_node::close()
     const auto p2p_close = p2p::close();
     const auto chain_close = chain_.close();
 
+    store_pool_.join();
+
     if (!p2p_close)
         LOG_ERROR(LOG_NODE)
             << "Failed to close network.";
@@ -334,6 +815,71 @@ reservation::ptr full_node::get_reservation()
     return reservations_.get();
 }
 
+void full_node::announce(const hash_digest& hash, uint64_t channel)
+{
+    reservations_.announce(hash, channel);
+}
+
+peer_history& full_node::history()
+{
+    return history_;
+}
+
+outbound_scaler& full_node::scaler()
+{
+    return scaler_;
+}
+
+sync_phase& full_node::phase()
+{
+    return phase_;
+}
+
+threadpool& full_node::store_pool()
+{
+    return store_pool_;
+}
+
+timing_wheel& full_node::deadlines()
+{
+    return deadlines_;
+}
+
+upload_scheduler& full_node::uploads()
+{
+    return uploads_;
+}
+
+filter_index& full_node::filters()
+{
+    return filters_;
+}
+
+transaction_requests& full_node::requests()
+{
+    return requests_;
+}
+
+orphan_pool& full_node::orphans()
+{
+    return orphans_;
+}
+
+rolling_filter& full_node::rejected()
+{
+    return rejected_;
+}
+
+pool_index& full_node::mempool()
+{
+    return mempool_;
+}
+
+relay_buckets& full_node::relay()
+{
+    return relay_;
+}
+
 // Subscriptions.
 // ----------------------------------------------------------------------------
 
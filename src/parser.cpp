@@ -479,6 +479,31 @@ options_metadata parser::load_settings(config::configuration *pconf)
         value<uint32_t>(&nodeconf->node->block_latency_seconds),
         "The maximum time to wait for a requested block, defaults to 5."
     )
+    (
+        "node.sync_outbound_connections",
+        value<uint32_t>(&nodeconf->node->sync_outbound_connections),
+        "The maximum outbound connections while syncing blocks, defaults to 24."
+    )
+    (
+        "node.download_budget_megabytes",
+        value<uint32_t>(&nodeconf->node->download_budget_megabytes),
+        "The maximum estimated size of requested blocks, defaults to 1024 (0 unlimited)."
+    )
+    (
+        "node.download_lookahead_blocks",
+        value<uint32_t>(&nodeconf->node->download_lookahead_blocks),
+        "The maximum height above the top validated block to download, defaults to 5000 (0 unlimited)."
+    )
+    (
+        "node.store_threads",
+        value<uint32_t>(&nodeconf->node->store_threads),
+        "The number of threads for header organization, block import and store writes, defaults to 0 (physical cores)."
+    )
+    (
+        "node.store_priority",
+        value<bool>(&nodeconf->node->store_priority),
+        "Use high thread priority for store threads, defaults to false."
+    )
     (
         /* Internally this is blockchain, but it is conceptually a node setting. */
         "node.notify_limit_hours",
@@ -514,6 +539,16 @@ options_metadata parser::load_settings(config::configuration *pconf)
         value<bool>(&nodeconf->node->refresh_transactions),
         "Request transactions on each channel start, defaults to false."
     )
+    (
+        "node.upload_kilobytes_per_second",
+        value<uint32_t>(&nodeconf->node->upload_kilobytes_per_second),
+        "The maximum aggregate block upload rate, defaults to 0 (unlimited)."
+    )
+    (
+        "node.compact_filters",
+        value<bool>(&nodeconf->node->compact_filters),
+        "Index and serve BIP158 compact block filters, defaults to false."
+    )
 
     /* [bitcoin] */
     (
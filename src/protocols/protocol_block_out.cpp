@@ -24,6 +24,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 #include <boost/range/adaptor/reversed.hpp>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
@@ -42,17 +43,50 @@ using namespace bc::network;
 using namespace boost::adaptors;
 using namespace std::placeholders;
 
+// Blocks known to the peer are not announced to it.
+static constexpr size_t known_capacity = 1000;
+static constexpr double known_false_positive_rate = 0.000001;
+
 inline bool is_witness(uint64_t services)
 {
     return (services & version::service::node_witness) != 0;
 }
 
+// Serializes a transaction of a shared block as a transaction message, so that
+// filtered block matches are sent without copying them from the block (BIP37).
+class block_transaction
+{
+public:
+    static const std::string command;
+
+    block_transaction(const chain::transaction& tx)
+      : tx_(tx)
+    {
+    }
+
+    data_chunk to_data(uint32_t) const
+    {
+        return tx_.to_data(true, false);
+    }
+
+    size_t serialized_size(uint32_t) const
+    {
+        return tx_.serialized_size(true, false);
+    }
+
+private:
+    const chain::transaction& tx_;
+};
+
+const std::string block_transaction::command = "tx";
+
 // TODO: break out protocol_header_out.
 protocol_block_out::protocol_block_out(full_node& node, channel::ptr channel,
     safe_chain& chain)
   : protocol_events(node, channel, NAME),
     node_(node),
     chain_(chain),
+    uploads_(node.uploads()),
     last_locator_top_(null_hash),
 
     // TODO: move send_compact to a derived class protocol_block_out_70014.
@@ -63,6 +97,7 @@ protocol_block_out::protocol_block_out(full_node& node, channel::ptr channel,
 
     // Witness requests must be allowed if advertising the service.
     enable_witness_(is_witness(node.network_settings().services)),
+    known_(known_capacity, known_false_positive_rate),
     CONSTRUCT_TRACK(protocol_block_out)
 {
 }
@@ -89,11 +124,24 @@ void protocol_block_out::start()
         SUBSCRIBE2(send_headers, handle_receive_send_headers, _1, _2);
     }
 
+    // TODO: move filters to a derived class protocol_block_out_70001.
+    if (negotiated_version() >= version::level::bip37)
+    {
+        // Filter merkle blocks (filtered_block requests) by peer filter.
+        SUBSCRIBE2(filter_load, handle_receive_filter_load, _1, _2);
+        SUBSCRIBE2(filter_add, handle_receive_filter_add, _1, _2);
+        SUBSCRIBE2(filter_clear, handle_receive_filter_clear, _1, _2);
+    }
+
     // TODO: move get_headers to a derived class protocol_block_out_31800.
     SUBSCRIBE2(get_headers, handle_receive_get_headers, _1, _2);
     SUBSCRIBE2(get_blocks, handle_receive_get_blocks, _1, _2);
     SUBSCRIBE2(get_data, handle_receive_get_data, _1, _2);
 
+    // Blocks announced by the peer are known to it.
+    SUBSCRIBE2(inventory, handle_receive_inventory, _1, _2);
+    SUBSCRIBE2(headers, handle_receive_headers, _1, _2);
+
     // Subscribe to block acceptance notifications (the block-out heartbeat).
     chain_.subscribe_blocks(BIND4(handle_reorganized, _1, _2, _3, _4));
 }
@@ -125,6 +173,124 @@ bool protocol_block_out::handle_receive_send_headers(const code& ec,
     return false;
 }
 
+// Receive filter_load, filter_add and filter_clear.
+//-----------------------------------------------------------------------------
+
+// TODO: move filters to a derived class protocol_block_out_70001.
+bool protocol_block_out::handle_receive_filter_load(const code& ec,
+    filter_load_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto filter = std::make_shared<bloom_filter>(message->filter(),
+        message->hash_functions(), message->tweak(), message->flags());
+
+    if (!filter->is_valid())
+    {
+        LOG_WARNING(LOG_NODE)
+            << "Invalid filter_load size (" << message->filter().size()
+            << ") from [" << authority() << "]";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(filter_mutex_);
+
+    // A filter replaces any previously-loaded filter.
+    filter_ = filter;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// TODO: move filters to a derived class protocol_block_out_70001.
+bool protocol_block_out::handle_receive_filter_add(const code& ec,
+    filter_add_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    const auto& data = message->data();
+
+    if (data.size() > bloom_filter::max_element_bytes)
+    {
+        LOG_WARNING(LOG_NODE)
+            << "Invalid filter_add size (" << data.size() << ") from ["
+            << authority() << "]";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    filter_mutex_.lock_upgrade();
+
+    if (!filter_)
+    {
+        filter_mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        LOG_WARNING(LOG_NODE)
+            << "Unexpected filter_add from [" << authority() << "]";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    filter_mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    filter_->insert(data);
+
+    filter_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    return true;
+}
+
+// TODO: move filters to a derived class protocol_block_out_70001.
+bool protocol_block_out::handle_receive_filter_clear(const code& ec,
+    filter_clear_const_ptr)
+{
+    if (stopped(ec))
+        return false;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(filter_mutex_);
+
+    filter_.reset();
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Receive inventory and headers.
+//-----------------------------------------------------------------------------
+
+bool protocol_block_out::handle_receive_inventory(const code& ec,
+    inventory_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    for (const auto& inventory: message->inventories())
+        if (inventory.is_block_type())
+            known_.insert(inventory.hash());
+
+    return true;
+}
+
+bool protocol_block_out::handle_receive_headers(const code& ec,
+    headers_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    for (const auto& header: message->elements())
+        known_.insert(header.hash());
+
+    return true;
+}
+
 // Receive get_headers sequence.
 //-----------------------------------------------------------------------------
 
@@ -301,6 +467,7 @@ bool protocol_block_out::handle_receive_get_data(const code& ec,
     return true;
 }
 
+// Store reads are scheduled node-wide so that no one peer monopolizes them.
 void protocol_block_out::send_next_data(inventory_ptr inventory)
 {
     if (inventory->inventories().empty())
@@ -309,6 +476,19 @@ void protocol_block_out::send_next_data(inventory_ptr inventory)
     // The order is reversed so that we can pop from the back.
     const auto& entry = inventory->inventories().back();
 
+    uploads_.enqueue(nonce(), entry.hash(),
+        BIND2(handle_upload, _1, inventory));
+}
+
+void protocol_block_out::handle_upload(const code& ec,
+    inventory_ptr inventory)
+{
+    if (stopped(ec))
+        return;
+
+    BITCOIN_ASSERT(!inventory->inventories().empty());
+    const auto& entry = inventory->inventories().back();
+
     switch (entry.type())
     {
         case inventory::type_id::witness_block:
@@ -331,8 +511,20 @@ void protocol_block_out::send_next_data(inventory_ptr inventory)
         }
         case inventory::type_id::filtered_block:
         {
-            chain_.fetch_merkle_block(entry.hash(),
-                BIND4(send_merkle_block, _1, _2, _3, inventory));
+            // Keep outside of lock, okay if filter changes before fetch.
+            auto filtered = false;
+            {
+                shared_lock lock(filter_mutex_);
+                filtered = !!filter_;
+            }
+
+            // A filtered merkle block is built from the full block.
+            if (filtered)
+                chain_.fetch_block(entry.hash(), false,
+                    BIND4(send_filtered_block, _1, _2, _3, inventory));
+            else
+                chain_.fetch_merkle_block(entry.hash(),
+                    BIND4(send_merkle_block, _1, _2, _3, inventory));
             break;
         }
         case inventory::type_id::compact_block:
@@ -344,6 +536,10 @@ void protocol_block_out::send_next_data(inventory_ptr inventory)
         default:
         {
             BITCOIN_ASSERT_MSG(false, "improperly-filtered inventory");
+
+            // Release the grant so that it is not held by the channel.
+            uploads_.complete(nonce(), entry.hash(), 0);
+            handle_send_next(error::success, inventory);
         }
     }
 }
@@ -361,9 +557,9 @@ void protocol_block_out::send_block(const code& ec, block_const_ptr message,
 
         // TODO: move not_found to derived class protocol_block_out_70001.
         BITCOIN_ASSERT(!inventory->inventories().empty());
-        const not_found reply{ inventory->inventories().back() };
-        SEND2(reply, handle_send, _1, reply.command);
-        handle_send_next(error::success, inventory);
+        const auto& entry = inventory->inventories().back();
+        const not_found reply{ entry };
+        SEND3(reply, handle_upload_sent, _1, 0, inventory);
         return;
     }
 
@@ -376,7 +572,11 @@ void protocol_block_out::send_block(const code& ec, block_const_ptr message,
         return;
     }
 
-    SEND2(*message, handle_send_next, _1, inventory);
+    // A served block is known to the peer, so it is not announced to it.
+    known_.insert(message->hash());
+
+    const auto size = message->serialized_size(negotiated_version());
+    SEND3(*message, handle_upload_sent, _1, size, inventory);
 }
 
 // TODO: move merkle_block to derived class protocol_block_out_70001.
@@ -393,9 +593,9 @@ void protocol_block_out::send_merkle_block(const code& ec,
 
         // TODO: move not_found to derived class protocol_block_out_70001.
         BITCOIN_ASSERT(!inventory->inventories().empty());
-        const not_found reply{ inventory->inventories().back() };
-        SEND2(reply, handle_send, _1, reply.command);
-        handle_send_next(error::success, inventory);
+        const auto& entry = inventory->inventories().back();
+        const not_found reply{ entry };
+        SEND3(reply, handle_upload_sent, _1, 0, inventory);
         return;
     }
 
@@ -408,7 +608,88 @@ void protocol_block_out::send_merkle_block(const code& ec,
         return;
     }
 
-    SEND2(*message, handle_send_next, _1, inventory);
+    known_.insert(message->header().hash());
+
+    const auto size = message->serialized_size(negotiated_version());
+    SEND3(*message, handle_upload_sent, _1, size, inventory);
+}
+
+// TODO: move merkle_block to derived class protocol_block_out_70001.
+void protocol_block_out::send_filtered_block(const code& ec,
+    block_const_ptr message, size_t, inventory_ptr inventory)
+{
+    if (stopped(ec))
+        return;
+
+    if (ec == error::not_found)
+    {
+        LOG_DEBUG(LOG_NODE)
+            << "Filtered block requested by [" << authority()
+            << "] not found.";
+
+        // TODO: move not_found to derived class protocol_block_out_70001.
+        BITCOIN_ASSERT(!inventory->inventories().empty());
+        const auto& entry = inventory->inventories().back();
+        const not_found reply{ entry };
+        SEND3(reply, handle_upload_sent, _1, 0, inventory);
+        return;
+    }
+
+    if (ec)
+    {
+        LOG_ERROR(LOG_NODE)
+            << "Internal failure locating filtered block requested by ["
+            << authority() << "] " << ec.message();
+        stop(ec);
+        return;
+    }
+
+    known_.insert(message->hash());
+
+    bloom_filter::matches matched;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    filter_mutex_.lock();
+
+    // All transactions are matched in one pass, updating the filter.
+    if (filter_)
+        matched = filter_->match(*message);
+    else
+        matched.assign(message->transactions().size(), false);
+
+    filter_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto merkle = bloom_filter::to_merkle_block(*message, matched);
+    const auto& transactions = message->transactions();
+    auto size = merkle->serialized_size(negotiated_version());
+    std::vector<block_transaction> matches;
+
+    // Matches refer to the block, which outlives each (serializing) send.
+    for (size_t position = 0; position < matched.size(); ++position)
+    {
+        if (!matched[position])
+            continue;
+
+        matches.emplace_back(transactions[position]);
+        size += matches.back().serialized_size(negotiated_version());
+    }
+
+    // The grant is completed once the last message of the upload is sent.
+    if (matches.empty())
+    {
+        SEND3(*merkle, handle_upload_sent, _1, size, inventory);
+        return;
+    }
+
+    SEND2(*merkle, handle_send, _1, merkle->command);
+
+    // Matched transactions follow the merkle block (BIP37).
+    for (size_t match = 0; match + 1u < matches.size(); ++match)
+        SEND2(matches[match], handle_send, _1, matches[match].command);
+
+    SEND3(matches.back(), handle_upload_sent, _1, size, inventory);
 }
 
 // TODO: move merkle_block to derived class protocol_block_out_70014.
@@ -425,9 +706,9 @@ void protocol_block_out::send_compact_block(const code& ec,
 
         // TODO: move not_found to derived class protocol_block_out_70001.
         BITCOIN_ASSERT(!inventory->inventories().empty());
-        const not_found reply{ inventory->inventories().back() };
-        SEND2(reply, handle_send, _1, reply.command);
-        handle_send_next(error::success, inventory);
+        const auto& entry = inventory->inventories().back();
+        const not_found reply{ entry };
+        SEND3(reply, handle_upload_sent, _1, 0, inventory);
         return;
     }
 
@@ -440,7 +721,24 @@ void protocol_block_out::send_compact_block(const code& ec,
         return;
     }
 
-    SEND2(*message, handle_send_next, _1, inventory);
+    known_.insert(message->header().hash());
+
+    const auto size = message->serialized_size(negotiated_version());
+    SEND3(*message, handle_upload_sent, _1, size, inventory);
+}
+
+// The upload grant covers the send, so that the scheduler limits bandwidth.
+void protocol_block_out::handle_upload_sent(const code& ec, size_t size,
+    inventory_ptr inventory)
+{
+    // A stopped channel releases its grant in handle_stop.
+    if (stopped(ec))
+        return;
+
+    BITCOIN_ASSERT(!inventory->inventories().empty());
+    const auto& entry = inventory->inventories().back();
+    uploads_.complete(nonce(), entry.hash(), size);
+    handle_send_next(error::success, inventory);
 }
 
 void protocol_block_out::handle_send_next(const code& ec,
@@ -489,7 +787,7 @@ bool protocol_block_out::handle_reorganized(code ec, size_t,
         // TODO: move compact_block to a derived class protocol_block_out_70014.
         const auto block = incoming->front();
 
-        if (block->header().metadata.originator != nonce())
+        if (is_announceable(block->header()))
         {
             // TODO: construct a compact block from a block and a nonce.
             ////compact_block announce(block, pseudo_random(1, max_uint64));
@@ -505,7 +803,7 @@ bool protocol_block_out::handle_reorganized(code ec, size_t,
         headers announce;
 
         for (const auto block: *incoming)
-            if (block->header().metadata.originator != nonce())
+            if (is_announceable(block->header()))
                 announce.elements().push_back(block->header());
 
         if (!announce.elements().empty())
@@ -525,7 +823,7 @@ bool protocol_block_out::handle_reorganized(code ec, size_t,
         inventory announce;
 
         for (const auto block: *incoming)
-            if (block->header().metadata.originator != nonce())
+            if (is_announceable(block->header()))
                 announce.inventories().push_back(
                     { inventory::type_id::block, block->header().hash() });
 
@@ -543,9 +841,23 @@ bool protocol_block_out::handle_reorganized(code ec, size_t,
     }
 }
 
+// Blocks originated by or known to the peer are not announced, and a block is
+// known to the peer once announced.
+bool protocol_block_out::is_announceable(const chain::header& header)
+{
+    const auto hash = header.hash();
+
+    if (header.metadata.originator == nonce() || known_.contains(hash))
+        return false;
+
+    known_.insert(hash);
+    return true;
+}
+
 void protocol_block_out::handle_stop(const code&)
 {
     chain_.unsubscribe();
+    uploads_.remove(nonce());
 
     LOG_VERBOSE(LOG_NODE)
         << "Stopped block_out protocol for [" << authority() << "].";
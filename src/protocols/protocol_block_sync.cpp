@@ -19,7 +19,9 @@
 #include <bitcoin/node/protocols/protocol_block_sync.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <stdexcept>
 #include <bitcoin/blockchain.hpp>
@@ -39,15 +41,22 @@ using namespace bc::message;
 using namespace bc::network;
 using namespace std::placeholders;
 
-// The moving window in which block average download rate is measured.
-static const asio::seconds monitor_interval(5);
+// Requests are withheld while this many received blocks await import.
+static constexpr size_t maximum_pending_imports = 8;
 
 // Depends on protocol_header_sync, which requires protocol version 31800.
 protocol_block_sync::protocol_block_sync(full_node& node, channel::ptr channel,
     safe_chain& chain)
-  : protocol_timer(node, channel, true, NAME),
+  : protocol_events(node, channel, NAME),
     chain_(chain),
+    history_(node.history()),
+    deadlines_(node.deadlines()),
+    store_(node.store_pool()),
+    block_latency_(node.node_settings().block_latency()),
     reservation_(node.get_reservation()),
+    stalled_(false),
+    importing_(false),
+    latency_(0),
     CONSTRUCT_TRACK(protocol_block_sync)
 {
 }
@@ -57,10 +66,12 @@ protocol_block_sync::protocol_block_sync(full_node& node, channel::ptr channel,
 
 void protocol_block_sync::start()
 {
-    protocol_timer::start(monitor_interval, BIND1(handle_event, _1));
+    protocol_events::start(BIND1(handle_stop, _1));
 
-    chain_.subscribe_headers(BIND4(handle_reindexed, _1, _2, _3, _4));
+    // Header reindexation is dispatched by the node to slots that gain work.
+    reservation_->set_waker(nonce(), BIND1(handle_wake, _1));
     SUBSCRIBE2(block, handle_receive_block, _1, _2);
+    set_deadline();
 
     // This is the end of the start sequence.
     send_get_blocks();
@@ -76,6 +87,17 @@ void protocol_block_sync::send_get_blocks()
     if (stopped())
         return;
 
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+    const auto backlogged = pending_.size() >= maximum_pending_imports;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Requests resume as the backlog is imported.
+    if (backlogged)
+        return;
+
     // Don't start downloading blocks until the header chain is current.
     // This protects against disk fill and allows hashes to be distributed.
     // BUG: default to 24 hours before the candidate is stale? what?? also, is this formerly candidates_stale() but now confirmed_stale() instead?? (a kind of flag inversion?)
@@ -94,9 +116,37 @@ void protocol_block_sync::send_get_blocks()
         << " Sending request of " << request.inventories().size()
         << " hashes for slot (" << reservation_->slot() << ").";
 
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto now = asio::steady_clock::now();
+    active_ = now;
+
+    // Latency is measured from the first unanswered request.
+    if (requested_ == asio::time_point{})
+        requested_ = now;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    set_deadline();
     SEND2(request, handle_send, _1, request.command);
 }
 
+// The slot is stopped by partition, and may then be assigned to another channel.
+bool protocol_block_sync::partitioned() const
+{
+    return reservation_->stopped() || reservation_->channel() != nonce();
+}
+
+// Each request or block defers the slot deadline by one block interval.
+void protocol_block_sync::set_deadline()
+{
+    deadlines_.schedule(nonce(), block_latency_,
+        BIND1(handle_deadline, _1));
+}
+
 bool protocol_block_sync::handle_receive_block(const code& ec,
     block_const_ptr message)
 {
@@ -116,7 +166,7 @@ bool protocol_block_sync::handle_receive_block(const code& ec,
     }
 
     // This channel was slowest, so half of its reservation has been taken.
-    if (reservation_->stopped())
+    if (partitioned())
     {
         LOG_DEBUG(LOG_NODE)
             << this_id
@@ -133,6 +183,15 @@ bool protocol_block_sync::handle_receive_block(const code& ec,
     // There is currently no way to know the difference, so log both options.
     if (!reservation_->find_height_and_erase(message->hash(), height))
     {
+        // A block expedited to another slot may still arrive here.
+        if (reservation_->find_released_and_erase(message->hash()))
+        {
+            LOG_DEBUG(LOG_NODE)
+                << "Ignored expedited block [" << encode_hash(message->hash())
+                << "] on slot (" << reservation_->slot() << ").";
+            return true;
+        }
+
         LOG_DEBUG(LOG_NODE)
             << this_id
             << " Unrequested or partitioned block on slot ("
@@ -141,11 +200,53 @@ bool protocol_block_sync::handle_receive_block(const code& ec,
         return false;
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto now = asio::steady_clock::now();
+    active_ = now;
+
+    if (requested_ != asio::time_point{})
+    {
+        const auto sample = static_cast<uint32_t>(
+            std::chrono::duration_cast<asio::milliseconds>(
+                now - requested_).count());
+
+        latency_ = latency_ == 0 ? sample : (latency_ + sample) / 2u;
+        requested_ = asio::time_point{};
+    }
+
+    // Imports are serialized in order of receipt, one at a time per channel.
+    const auto import = !importing_;
+
+    if (importing_)
+        pending_.emplace_back(message, height);
+    else
+        importing_ = true;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
     LOG_DEBUG(LOG_NODE)
     << this_id
-    << " calling reservation_->import() at height: "
+    << " posting reservation_->import() at height: "
     << height;
 
+    // The import is posted to the store pool, so that the network thread is
+    // not held by store writes. The block is no longer reserved, so it is
+    // imported even if the channel stops before the import runs.
+    if (import)
+        store_.service().post(BIND2(handle_import, message, height));
+
+    return true;
+}
+
+void protocol_block_sync::handle_import(block_const_ptr message,
+    size_t height)
+{
+    const auto this_id = boost::this_thread::get_id();
+
     // Add the block's transactions to the store.
     // If this is the validation target then validator advances here.
     // Block validation failure will not cause an error here.
@@ -161,73 +262,146 @@ bool protocol_block_sync::handle_receive_block(const code& ec,
             << " Failure importing block for slot (" << reservation_->slot()
             << "), store is now corrupted: " << error_code << " " << error_code.message();
         stop(error_code);
-        return false;
+        return;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock();
+
+    const auto import = !pending_.empty();
+    importing_ = import;
+    pending_block next;
+
+    if (import)
+    {
+        next = pending_.front();
+        pending_.pop_front();
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Pending blocks are imported even if the channel has stopped.
+    if (import)
+        store_.service().post(BIND2(handle_import, next.first, next.second));
+
+    if (stopped())
+        return;
+
+    // Expiry is evaluated as the slot's rate is updated.
+    if (reservation_->expired())
+    {
+        expire(false);
+        return;
     }
 
+    set_deadline();
     send_get_blocks();
-    return true;
 }
 
 // Events.
 // ----------------------------------------------------------------------------
 
 // Use header indexation as a block request trigger.
-bool protocol_block_sync::handle_reindexed(code ec, size_t,
-    header_const_ptr_list_const_ptr, header_const_ptr_list_const_ptr)
+void protocol_block_sync::handle_wake(const code& ec)
 {
     if (stopped(ec))
-        return false;
+        return;
 
-    if (ec)
+    // A partitioned slot is woken so that its channel restarts.
+    if (partitioned())
     {
-        LOG_ERROR(LOG_NODE)
-            << "Failure in header index for slot (" << reservation_->slot()
-            << ") " << ec.message();
-        stop(ec);
-        return false;
+        LOG_DEBUG(LOG_NODE)
+            << "Restarting partitioned slot (" << reservation_->slot()
+            << ") : [" << reservation_->size() << "]";
+        stop(error::channel_stopped);
+        return;
     }
 
-    // When the queue is empty and a new header is announced the download is
-    // not directed to the peer that made the announcement. This can lead to
-    // delay in obtaining the block, which can be costly for mining. On the
-    // other hand optimal mining relies on the compact block protocol, not full
-    // block requests, so this is considered acceptable behavior here.
-
+    // When the queue is shallow and a new header is announced the download is
+    // directed to the peer that made the announcement, racing the fastest
+    // other slot. Otherwise hashes are requested in height order.
     send_get_blocks();
-    return true;
 }
 
-// Fired by base timer and stop handler.
-void protocol_block_sync::handle_event(const code& ec)
+// Fired when the slot has neither requested nor received a block within one
+// block interval, or when the idle allowance of a new slot may have expired.
+void protocol_block_sync::handle_deadline(const code& ec)
 {
     if (stopped(ec))
-    {
-        // No longer receiving blocks, so free up the reservation.
-        reservation_->stop();
-
-        // Trigger unsubscribe or protocol will hang until next header indexed.
-        chain_.unsubscribe();
         return;
-    }
 
-    if (ec && ec != error::channel_timeout)
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+    const auto active = active_;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    const auto waiting = asio::steady_clock::now() - active >= block_latency_;
+    const auto stalled = waiting && reservation_->requested() != 0;
+
+    // This ensures that a stall does not persist.
+    if (stalled || reservation_->expired())
     {
-        LOG_ERROR(LOG_NODE)
-            << "Failure in block sync timer for slot (" << reservation_->slot()
-            << ") " << ec.message();
-        stop(ec);
+        expire(stalled);
         return;
     }
 
-    // This ensures that a stall does not persist.
-    if (reservation_->expired())
+    // Resume a request throttled by the download budget.
+    set_deadline();
+    send_get_blocks();
+}
+
+// Only an unanswered request is recorded as a stall, as a slot expired for its
+// rate deviation is slow but live.
+void protocol_block_sync::expire(bool stalled)
+{
+    LOG_DEBUG(LOG_NODE)
+        << "Restarting " << (stalled ? "stalled" : "slow") << " slot ("
+        << reservation_->slot() << ") : [" << reservation_->size() << "]";
+
+    if (stalled)
     {
-        LOG_DEBUG(LOG_NODE)
-            << "Restarting slow slot (" << reservation_->slot() << ") : ["
-            << reservation_->size() << "]";
-        stop(ec);
-        return;
+        ///////////////////////////////////////////////////////////////////////
+        // Critical Section
+        mutex_.lock();
+        stalled_ = true;
+        mutex_.unlock();
+        ///////////////////////////////////////////////////////////////////////
     }
+
+    stop(error::channel_timeout);
+}
+
+void protocol_block_sync::handle_stop(const code& ec)
+{
+    // Record performance before the reservation is reset.
+    record_history(ec);
+
+    // No longer receiving blocks, so free up the reservation (if still ours).
+    reservation_->stop(nonce());
+
+    // The deadline holds this protocol, so it is released here.
+    deadlines_.cancel(nonce());
+}
+
+// Download performance outlives the channel to inform outbound selection.
+void protocol_block_sync::record_history(const code& reason)
+{
+    const auto current = reservation_->rate();
+    const auto rate = current.idle ? 0.0 : current.rate() * 1000000;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    mutex_.lock_shared();
+    const auto stalled = stalled_;
+    const auto latency = latency_;
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    history_.record(authority(), rate, latency, stalled, reason);
 }
 
 } // namespace node
@@ -0,0 +1,237 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/protocols/protocol_filter_out.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <bitcoin/network.hpp>
+#include <bitcoin/node/define.hpp>
+#include <bitcoin/node/full_node.hpp>
+#include <bitcoin/node/utility/block_filter.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+#define NAME "filter_out"
+#define CLASS protocol_filter_out
+
+using namespace bc::message;
+using namespace bc::network;
+using namespace std::placeholders;
+
+// BIP157 response limits.
+static constexpr size_t max_filters = 1000;
+static constexpr size_t max_filter_headers = 2000;
+static constexpr size_t checkpoint_interval = 1000;
+
+protocol_filter_out::protocol_filter_out(full_node& network,
+    channel::ptr channel)
+  : protocol_events(network, channel, NAME),
+    filters_(network.filters()),
+    CONSTRUCT_TRACK(protocol_filter_out)
+{
+}
+
+// Start.
+//-----------------------------------------------------------------------------
+
+void protocol_filter_out::start()
+{
+    protocol_events::start();
+
+    SUBSCRIBE2(get_compact_filters, handle_receive_get_filters, _1, _2);
+    SUBSCRIBE2(get_compact_filter_headers, handle_receive_get_filter_headers,
+        _1, _2);
+    SUBSCRIBE2(get_compact_filter_checkpoint,
+        handle_receive_get_filter_checkpoint, _1, _2);
+}
+
+// Utilities.
+//-----------------------------------------------------------------------------
+
+// The stop hash must be indexed and the range within the limit.
+bool protocol_filter_out::get_stop_height(size_t& out_height,
+    uint8_t filter_type, size_t start_height, const hash_digest& stop_hash,
+    size_t limit) const
+{
+    return filter_type == block_filter::basic_type &&
+        filters_.get_height(out_height, stop_hash) &&
+        start_height <= out_height && out_height - start_height < limit;
+}
+
+// A failed index is not served, as it is not current.
+bool protocol_filter_out::handle_unavailable()
+{
+    LOG_DEBUG(LOG_NODE)
+        << "Compact filters requested by [" << authority()
+        << "] are unavailable.";
+    stop(error::channel_stopped);
+    return false;
+}
+
+// Receive getcfilters sequence.
+//-----------------------------------------------------------------------------
+
+bool protocol_filter_out::handle_receive_get_filters(const code& ec,
+    get_compact_filters_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    if (!filters_.available())
+        return handle_unavailable();
+
+    size_t stop_height;
+    const size_t start_height = message->start_height();
+
+    if (!get_stop_height(stop_height, message->filter_type(), start_height,
+        message->stop_hash(), max_filters))
+    {
+        LOG_WARNING(LOG_NODE)
+            << "Invalid getcfilters request from [" << authority() << "]";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    data_chunk filter;
+    hash_digest block_hash;
+    hash_digest filter_hash;
+    hash_digest filter_header;
+
+    for (auto height = start_height; height <= stop_height; ++height)
+    {
+        if (!filters_.get_hashes(block_hash, filter_hash, filter_header,
+            height) || !filters_.get_filter(filter, height))
+        {
+            // The index may have been reorganized below the stop height.
+            LOG_DEBUG(LOG_NODE)
+                << "Filter (" << height << ") requested by ["
+                << authority() << "] not found.";
+            break;
+        }
+
+        const compact_filter reply{ block_filter::basic_type, block_hash,
+            filter };
+        SEND2(reply, handle_send, _1, reply.command);
+    }
+
+    return true;
+}
+
+// Receive getcfheaders sequence.
+//-----------------------------------------------------------------------------
+
+bool protocol_filter_out::handle_receive_get_filter_headers(const code& ec,
+    get_compact_filter_headers_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    if (!filters_.available())
+        return handle_unavailable();
+
+    size_t stop_height;
+    const size_t start_height = message->start_height();
+
+    if (!get_stop_height(stop_height, message->filter_type(), start_height,
+        message->stop_hash(), max_filter_headers))
+    {
+        LOG_WARNING(LOG_NODE)
+            << "Invalid getcfheaders request from [" << authority() << "]";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    hash_digest block_hash;
+    hash_digest filter_hash;
+    hash_digest filter_header;
+    hash_digest previous_header = null_hash;
+
+    // The header preceding the start height (null for genesis).
+    if (start_height > 0 && !filters_.get_hashes(block_hash, filter_hash,
+        previous_header, start_height - 1u))
+        return true;
+
+    hash_list filter_hashes;
+    filter_hashes.reserve(stop_height - start_height + 1u);
+
+    for (auto height = start_height; height <= stop_height; ++height)
+    {
+        if (!filters_.get_hashes(block_hash, filter_hash, filter_header,
+            height))
+            return true;
+
+        filter_hashes.push_back(filter_hash);
+    }
+
+    const compact_filter_headers reply{ block_filter::basic_type,
+        message->stop_hash(), previous_header, filter_hashes };
+    SEND2(reply, handle_send, _1, reply.command);
+    return true;
+}
+
+// Receive getcfcheckpt sequence.
+//-----------------------------------------------------------------------------
+
+bool protocol_filter_out::handle_receive_get_filter_checkpoint(
+    const code& ec, get_compact_filter_checkpoint_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    if (!filters_.available())
+        return handle_unavailable();
+
+    size_t stop_height;
+
+    // The checkpoint request is not range limited.
+    if (message->filter_type() != block_filter::basic_type ||
+        !filters_.get_height(stop_height, message->stop_hash()))
+    {
+        LOG_WARNING(LOG_NODE)
+            << "Invalid getcfcheckpt request from [" << authority() << "]";
+        stop(error::channel_stopped);
+        return false;
+    }
+
+    hash_digest block_hash;
+    hash_digest filter_hash;
+    hash_digest filter_header;
+    hash_list filter_headers;
+    filter_headers.reserve(stop_height / checkpoint_interval);
+
+    for (auto height = checkpoint_interval; height <= stop_height;
+        height += checkpoint_interval)
+    {
+        if (!filters_.get_hashes(block_hash, filter_hash, filter_header,
+            height))
+            return true;
+
+        filter_headers.push_back(filter_header);
+    }
+
+    const compact_filter_checkpoint reply{ block_filter::basic_type,
+        message->stop_hash(), filter_headers };
+    SEND2(reply, handle_send, _1, reply.command);
+    return true;
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -37,6 +37,9 @@ using namespace bc::message;
 using namespace bc::network;
 using namespace std::placeholders;
 
+// Headers messages up to this size are treated as block announcements.
+static constexpr size_t maximum_announcement = 8;
+
 // This creates pointer without copying the element and without destruct.
 static std::shared_ptr<header> unsafe_pointer( header& element)
 {
@@ -144,6 +147,13 @@ bool protocol_header_in::handle_receive_headers(const code& ec,
     }
 
     reset_timer();
+
+    // Once synced, announced blocks are requested directly from the peer.
+    if (message->elements().size() <= maximum_announcement &&
+        !chain_.is_blocks_stale())
+        for (const auto& header: message->elements())
+            node_.announce(header.hash(), nonce());
+
     store_header(0, message);
     return true;
 }
@@ -39,6 +39,9 @@ using namespace bc::message;
 using namespace bc::network;
 using namespace std::placeholders;
 
+// The interval at which timed out requests are reassigned.
+static const asio::seconds request_interval(1);
+
 inline bool is_witness(uint64_t services)
 {
     return (services & version::service::node_witness) != 0;
@@ -52,9 +55,13 @@ inline uint64_t to_relay_fee(float minimum_byte_fee)
 }
 
 protocol_transaction_in::protocol_transaction_in(full_node& node,
-    channel::ptr channel, safe_chain& chain)
-  : protocol_events(node, channel, NAME),
+    channel::ptr channel, safe_chain& chain, bool outbound)
+  : protocol_timer(node, channel, true, NAME),
     chain_(chain),
+    requests_(node.requests()),
+    orphans_(node.orphans()),
+    rejected_(node.rejected()),
+    outbound_(outbound),
 
     // TODO: move fee_filter to a derived class protocol_transaction_in_70013.
     minimum_relay_fee_(negotiated_version() >= version::level::bip133 ?
@@ -88,9 +95,11 @@ void protocol_transaction_in::start()
     if (require_witness_ && !peer_witness_)
         return;
 
-    protocol_events::start(BIND1(handle_stop, _1));
+    requests_.add(nonce(), outbound_);
+    protocol_timer::start(request_interval, BIND1(handle_event, _1));
 
     SUBSCRIBE2(inventory, handle_receive_inventory, _1, _2);
+    SUBSCRIBE2(not_found, handle_receive_not_found, _1, _2);
     SUBSCRIBE2(transaction, handle_receive_transaction, _1, _2);
 
     // TODO: move fee_filter to a derived class protocol_transaction_in_70013.
@@ -143,6 +152,18 @@ bool protocol_transaction_in::handle_receive_inventory(const code& ec,
     if (chain_.is_blocks_stale())
         return true;
 
+    auto& inventories = response->inventories();
+
+    // Remove hashes of transactions recently rejected under this tip.
+    inventories.erase(std::remove_if(inventories.begin(), inventories.end(),
+        [&](const inventory_vector& inventory)
+        {
+            return rejected_.contains(inventory.hash());
+        }), inventories.end());
+
+    if (inventories.empty())
+        return true;
+
     // Remove hashes of (unspent) transactions that we already have.
     // BUGBUG: this removes spent transactions which it should not (see BIP30).
     chain_.filter_transactions(response, BIND2(send_get_data, _1, response));
@@ -164,6 +185,24 @@ void protocol_transaction_in::send_get_data(const code& ec,
         return;
     }
 
+    auto& inventories = message->inventories();
+    const auto channel = nonce();
+
+    // Remove hashes in flight (or deferred) on any channel.
+    inventories.erase(std::remove_if(inventories.begin(), inventories.end(),
+        [&](const inventory_vector& inventory)
+        {
+            return !requests_.announce(channel, inventory.hash());
+        }), inventories.end());
+
+    send_request(message);
+}
+
+void protocol_transaction_in::send_request(get_data_ptr message)
+{
+    if (message->inventories().empty())
+        return;
+
     // Convert requested message types to corresponding witness types.
     if (require_witness_)
         message->to_witness();
@@ -201,11 +240,19 @@ bool protocol_transaction_in::handle_receive_transaction(const code& ec,
         return false;
     }
 
+    // The request is complete even if the transaction is not processed, so
+    // that it is not reassigned to another announcer.
+    requests_.complete(nonce(), message->hash());
+
     // TODO: manage channel relay at the service layer.
     // Do not process transactions while chain is stale.
     if (chain_.is_blocks_stale())
         return true;
 
+    // Transactions are not pre-verified here. Script verification requires
+    // previous outputs, which are populated by the organizer under its own
+    // lock, and the organizer has no entry point for verified transactions.
+    // So a stage here could run only context-free checks that it repeats.
     message->metadata.originator = nonce();
     chain_.organize(message, BIND2(handle_store_transaction, _1, message));
     return true;
@@ -220,11 +267,13 @@ void protocol_transaction_in::handle_store_transaction(const code& ec,
     if (stopped(ec))
         return;
 
-    // Ask the peer for ancestor txs if this one is an orphan.
-    // We may not get this transaction back, but that is a fair tradeoff for
-    // not having to store potentially invalid transactions.
+    // Retain the orphan and ask the peer for its missing parents.
+    // The orphan is organized by the node once its parents are accepted.
     if (ec == error::orphan_transaction)
+    {
+        orphans_.store(message);
         send_get_transactions(message);
+    }
 
     const auto encoded = encode_hash(message->hash());
 
@@ -237,6 +286,11 @@ void protocol_transaction_in::handle_store_transaction(const code& ec,
 
     if (ec)
     {
+        // Do not request the rejected transaction again until the tip changes.
+        if (ec != error::orphan_transaction &&
+            ec != error::duplicate_transaction)
+            rejected_.insert(message->hash());
+
         // This should not happen with a single peer since we filter inventory.
         // However it will happen when a block or another peer's tx intervenes.
         LOG_DEBUG(LOG_NODE)
@@ -252,10 +306,8 @@ void protocol_transaction_in::handle_store_transaction(const code& ec,
 
 // This will get chatty if the peer sends mempool response out of order.
 // This requests the next level of missing tx, but those may be orphans as
-// well. Those would also be discarded, until arriving at connectable txs.
-// There is no facility to re-obtain the dropped transactions. They must be
-// obtained coincidentally by peers, by a mempool message (new channel) or as a
-// result of transaction resends.
+// well. Those are also retained (within the orphan pool bounds), until
+// arriving at connectable txs.
 void protocol_transaction_in::send_get_transactions(
     transaction_const_ptr message)
 {
@@ -265,13 +317,56 @@ void protocol_transaction_in::send_get_transactions(
     send_get_data(error::success, request);
 }
 
-// Stop.
+// Receive not_found sequence.
 //-----------------------------------------------------------------------------
 
-void protocol_transaction_in::handle_stop(const code&)
+// TODO: move not_found to derived class protocol_transaction_in_70001.
+bool protocol_transaction_in::handle_receive_not_found(const code& ec,
+    not_found_const_ptr message)
 {
-    LOG_VERBOSE(LOG_NODE)
-        << "Stopped transaction_in protocol for [" << authority() << "].";
+    if (stopped(ec))
+        return false;
+
+    // The request falls back to another announcer (if any).
+    for (const auto& inventory: message->inventories())
+        if (inventory.is_transaction_type())
+            requests_.not_found(nonce(), inventory.hash());
+
+    return true;
+}
+
+// Timer.
+//-----------------------------------------------------------------------------
+
+void protocol_transaction_in::handle_event(const code& ec)
+{
+    if (stopped(ec))
+    {
+        // Requests of this channel fall back to other announcers.
+        requests_.remove(nonce());
+
+        LOG_VERBOSE(LOG_NODE)
+            << "Stopped transaction_in protocol for [" << authority() << "].";
+        return;
+    }
+
+    if (ec && ec != error::channel_timeout)
+    {
+        LOG_ERROR(LOG_NODE)
+            << "Failure in transaction request timer for [" << authority()
+            << "] " << ec.message();
+        stop(ec);
+        return;
+    }
+
+    // Request transactions that timed out on (or were deferred for) others.
+    auto hashes = requests_.reassigned(nonce());
+
+    if (hashes.empty())
+        return;
+
+    static const auto type = inventory::type_id::transaction;
+    send_request(std::make_shared<get_data>(std::move(hashes), type));
 }
 
 } // namespace node
@@ -18,10 +18,14 @@
  */
 #include <bitcoin/node/protocols/protocol_transaction_out.hpp>
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
-#include <boost/range/adaptor/reversed.hpp>
+#include <random>
+#include <utility>
+#include <vector>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/define.hpp>
 #include <bitcoin/node/full_node.hpp>
@@ -37,9 +41,19 @@ using namespace bc::chain;
 using namespace bc::database;
 using namespace bc::message;
 using namespace bc::network;
-using namespace boost::adaptors;
 using namespace std::placeholders;
 
+// The mean of the randomized (Poisson) transaction announcement interval.
+static const asio::milliseconds announce_interval(5000);
+
+// Requested transactions are fetched and sent in chunks of this many, so that
+// a large get_data does not buffer more than one chunk.
+static constexpr size_t maximum_fetch_transactions = 256;
+
+// Transactions known to the peer are not announced to it.
+static constexpr size_t known_capacity = 50000;
+static constexpr double known_false_positive_rate = 0.000001;
+
 inline bool is_witness(uint64_t services)
 {
     return (services & version::service::node_witness) != 0;
@@ -49,6 +63,8 @@ protocol_transaction_out::protocol_transaction_out(full_node& network,
     channel::ptr channel, safe_chain& chain)
   : protocol_events(network, channel, NAME),
     chain_(chain),
+    mempool_(network.mempool()),
+    relay_(network.relay()),
 
     // TODO: move fee filter to a derived class protocol_transaction_out_70013.
     minimum_peer_fee_(0),
@@ -58,6 +74,9 @@ protocol_transaction_out::protocol_transaction_out(full_node& network,
 
     // Witness requests must be allowed if advertising the service.
     enable_witness_(is_witness(network.network_settings().services)),
+    announce_timer_(std::make_shared<deadline>(pool(), announce_interval)),
+    known_(known_capacity, known_false_positive_rate),
+    generator_(std::random_device{}()),
     CONSTRUCT_TRACK(protocol_transaction_out)
 {
 }
@@ -75,8 +94,13 @@ void protocol_transaction_out::start()
     // Prior to this level transaction relay is not configurable.
     if (relay_to_peer_)
     {
-        // Subscribe to transaction pool notifications and relay txs.
-        chain_.subscribe_transactions(BIND2(handle_transaction_pool, _1, _2));
+        // Subscribe to pool notifications at or above the peer fee filter.
+        relay_.subscribe(nonce(), minimum_peer_fee_,
+            BIND2(handle_transaction_pool, _1, _2));
+
+        // Announcements are queued and sent in batches on a random timer.
+        SUBSCRIBE2(inventory, handle_receive_inventory, _1, _2);
+        schedule_announcements();
     }
 
     // TODO: move fee filter to a derived class protocol_transaction_out_70013.
@@ -101,6 +125,11 @@ bool protocol_transaction_out::handle_receive_fee_filter(const code& ec,
     // Transaction annoucements will be filtered by fee amount.
     minimum_peer_fee_ = message->minimum_fee();
 
+    // Move the relay subscription to the bucket of the new filter. This does
+    // not subscribe, so a filter received after stop is not resubscribed.
+    if (relay_to_peer_)
+        relay_.update(nonce(), minimum_peer_fee_);
+
     // The fee filter may be adjusted.
     return true;
 }
@@ -115,24 +144,70 @@ bool protocol_transaction_out::handle_receive_memory_pool(const code& ec,
     if (stopped(ec))
         return false;
 
-    // The handler may be invoked *multiple times* by one blockchain call.
-    // TODO: move multiple mempool inv to protocol_transaction_out_70002.
-    // TODO: move fee filter to a derived class protocol_transaction_out_70013.
-    chain_.fetch_mempool(max_inventory, minimum_peer_fee_,
-        BIND2(handle_fetch_mempool, _1, _2));
+    // Concurrent mempool streams are limited across all channels.
+    if (!mempool_.open_stream())
+    {
+        LOG_DEBUG(LOG_NODE)
+            << "Dropped mempool request from [" << authority()
+            << "] due to stream limit.";
+        return false;
+    }
+
+    send_next_mempool(pool_index::first);
 
     // Drop this subscription after the first request.
     return false;
 }
 
-// Each invocation is limited to 50000 vectors and invoked from common thread.
-void protocol_transaction_out::handle_fetch_mempool(const code& ec,
-    inventory_ptr message)
+// Each page follows the flush of the previous, so at most one page of
+// inventory is buffered per stream. The fee filter bounds the index read.
+void protocol_transaction_out::send_next_mempool(
+    const pool_index::cursor& after)
 {
-    if (stopped(ec) || message->inventories().empty())
+    const auto message = std::make_shared<inventory>();
+    auto& inventories = message->inventories();
+    auto cursor = after;
+    auto exhausted = false;
+
+    // TODO: move fee filter to a derived class protocol_transaction_out_70013.
+    // Pages wholly known to the peer are skipped without a send.
+    while (inventories.empty() && !exhausted)
+    {
+        hash_list hashes;
+        cursor = mempool_.page(hashes, cursor, minimum_peer_fee_,
+            max_inventory);
+        exhausted = hashes.size() < max_inventory;
+
+        for (const auto& hash: hashes)
+        {
+            // Do not announce transactions known to the peer.
+            if (known_.contains(hash))
+                continue;
+
+            known_.insert(hash);
+            inventories.emplace_back(inventory::type_id::transaction, hash);
+        }
+    }
+
+    if (inventories.empty())
+    {
+        mempool_.close_stream();
         return;
+    }
 
-    SEND2(*message, handle_send, _1, message->command);
+    SEND3(*message, handle_send_mempool, _1, cursor, exhausted);
+}
+
+void protocol_transaction_out::handle_send_mempool(const code& ec,
+    const pool_index::cursor& after, bool exhausted)
+{
+    if (stopped(ec) || ec || exhausted)
+    {
+        mempool_.close_stream();
+        return;
+    }
+
+    send_next_mempool(after);
 }
 
 // Receive get_data sequence.
@@ -148,149 +223,286 @@ bool protocol_transaction_out::handle_receive_get_data(const code& ec,
     if (stopped(ec))
         return false;
 
-    // Create a copy because message is const because it is shared.
-    const auto response = std::make_shared<inventory>();
+    const auto batch = std::make_shared<data_batch>();
+    auto& requests = batch->requests;
 
-    // Reverse copy the transaction elements of the const inventory.
-    for (const auto inventory: reverse(message->inventories()))
-        if (inventory.is_transaction_type())
-            response->inventories().push_back(inventory);
+    // Copy the transaction elements of the const inventory, in order.
+    for (const auto& inventory: message->inventories())
+    {
+        if (!inventory.is_transaction_type())
+            continue;
+
+        if (inventory.type() == inventory::type_id::witness_transaction &&
+            !enable_witness_)
+        {
+            stop(error::channel_stopped);
+            return false;
+        }
 
-    send_next_data(response);
+        requests.push_back(inventory);
+    }
+
+    if (requests.empty())
+        return true;
+
+    batch->offset = 0;
+    fetch_transactions(batch);
     return true;
 }
 
-void protocol_transaction_out::send_next_data(inventory_ptr inventory)
+// The transactions of a chunk are fetched in one pass, without a dispatch per
+// tx, and the next chunk is fetched once the last of these has been sent.
+void protocol_transaction_out::fetch_transactions(data_batch_ptr batch)
 {
-    if (inventory->inventories().empty())
-        return;
+    const auto& requests = batch->requests;
+    const auto start = batch->offset;
+    const auto end = std::min(start + maximum_fetch_transactions,
+        requests.size());
 
-    // The order is reversed so that we can pop from the back.
-    const auto& entry = inventory->inventories().back();
+    batch->transactions.assign(end - start, nullptr);
+    batch->remaining = end - start;
 
-    switch (entry.type())
+    for (auto index = start; index < end; ++index)
     {
-        case inventory::type_id::witness_transaction:
-        {
-            if (!enable_witness_)
-            {
-                stop(error::channel_stopped);
-                return;
-            }
-
-            chain_.fetch_transaction(entry.hash(), false, true,
-                BIND5(send_transaction, _1, _2, _3, _4, inventory));
-            break;
-        }
-        case inventory::type_id::transaction:
-        {
-            chain_.fetch_transaction(entry.hash(), false, false,
-                BIND5(send_transaction, _1, _2, _3, _4, inventory));
-            break;
-        }
-        default:
-        {
-            BITCOIN_ASSERT_MSG(false, "improperly-filtered inventory");
-        }
+        const auto& inventory = requests[index];
+        const auto witness = inventory.type() ==
+            inventory::type_id::witness_transaction;
+
+        // The height parameter is dropped by the binding.
+        chain_.fetch_transaction(inventory.hash(), false, witness,
+            BIND5(handle_fetch_transaction, _1, _2, _3, batch, index - start));
     }
 }
 
+void protocol_transaction_out::handle_fetch_transaction(const code& ec,
+    transaction_const_ptr message, size_t position, data_batch_ptr batch,
+    size_t index)
+{
+    // Treat already confirmed transactions as not found.
+    const auto confirmed = !ec && position != transaction_result::unconfirmed;
+
+    if (ec && ec != error::not_found && !stopped(ec))
+    {
+        LOG_ERROR(LOG_NODE)
+            << "Internal failure locating transaction requested by ["
+            << authority() << "] " << ec.message();
+        stop(ec);
+    }
+
+    if (!ec && !confirmed)
+        batch->transactions[index] = message;
+
+    if (--batch->remaining == 0)
+        send_transactions(batch);
+}
+
 // TODO: send block_transaction message as applicable.
-void protocol_transaction_out::send_transaction(const code& ec,
-    transaction_const_ptr message, size_t position, size_t /*height*/,
-    inventory_ptr inventory)
+// Transactions are written back-to-back, followed by one merged not_found.
+void protocol_transaction_out::send_transactions(data_batch_ptr batch)
 {
-    if (stopped(ec))
+    if (stopped())
         return;
 
-    // Treat already confirmed transactions as not found.
-    auto confirmed = !ec && position != transaction_result::unconfirmed;
+    transaction_const_ptr_list found;
+    const auto start = batch->offset;
 
-    if (ec == error::not_found || confirmed)
+    for (size_t index = 0; index < batch->transactions.size(); ++index)
     {
-        LOG_DEBUG(LOG_NODE)
-            << "Transaction requested by [" << authority() << "] not found.";
+        const auto& tx = batch->transactions[index];
 
-        // TODO: move not_found to derived class protocol_block_out_70001.
-        BITCOIN_ASSERT(!inventory->inventories().empty());
-        const not_found reply{ inventory->inventories().back() };
-        SEND2(reply, handle_send, _1, reply.command);
-        handle_send_next(error::success, inventory);
-        return;
+        if (tx)
+            found.push_back(tx);
+        else
+            batch->missing.push_back(batch->requests[start + index]);
     }
 
-    if (ec)
+    batch->offset += batch->transactions.size();
+    batch->transactions.clear();
+
+    if (found.empty())
     {
-        LOG_ERROR(LOG_NODE)
-            << "Internal failure locating transaction requested by ["
-            << authority() << "] " << ec.message();
-        stop(ec);
+        handle_send_transactions(error::success, batch);
         return;
     }
 
-    SEND2(*message, handle_send_next, _1, inventory);
+    for (const auto tx: found)
+        known_.insert(tx->hash());
+
+    // The send of the last transaction continues with the next chunk.
+    const auto last = found.back();
+    found.pop_back();
+
+    for (const auto tx: found)
+        SEND2(*tx, handle_send, _1, tx->command);
+
+    SEND2(*last, handle_send_transactions, _1, batch);
 }
 
-void protocol_transaction_out::handle_send_next(const code& ec,
-    inventory_ptr inventory)
+void protocol_transaction_out::handle_send_transactions(const code& ec,
+    data_batch_ptr batch)
 {
-    if (stopped(ec))
+    if (stopped(ec) || ec)
         return;
 
-    BITCOIN_ASSERT(!inventory->inventories().empty());
-    inventory->inventories().pop_back();
+    if (batch->offset < batch->requests.size())
+        fetch_transactions(batch);
+    else
+        send_not_found(batch);
+}
+
+void protocol_transaction_out::send_not_found(data_batch_ptr batch)
+{
+    if (batch->missing.empty())
+        return;
+
+    // TODO: move not_found to derived class protocol_block_out_70001.
+    not_found reply;
+    reply.inventories().swap(batch->missing);
+
+    LOG_DEBUG(LOG_NODE)
+        << "Transactions (" << reply.inventories().size()
+        << ") requested by [" << authority() << "] not found.";
 
-    // Break off recursion.
-    DISPATCH_CONCURRENT1(send_next_data, inventory);
+    SEND2(reply, handle_send, _1, reply.command);
 }
 
 // Subscription.
 //-----------------------------------------------------------------------------
 
-bool protocol_transaction_out::handle_transaction_pool(const code& ec,
-    transaction_const_ptr message)
+// Relay delivers only transactions at or above the peer fee filter, with the
+// fee rate computed once by the node.
+void protocol_transaction_out::handle_transaction_pool(
+    transaction_const_ptr message, uint64_t rate)
 {
-    if (stopped(ec))
-        return false;
-
-    if (ec)
-    {
-        LOG_ERROR(LOG_NODE)
-            << "Failure handling transaction notification: " << ec.message();
-        stop(ec);
-        return false;
-    }
-
-    // TODO: make this a collection and send empty in this case.
-    // Nothing to do, a channel is stopping but it's not this one.
-    if (!message)
-        return true;
+    if (stopped())
+        return;
 
     // Do not announce transactions to peer if too far behind.
     // Typically the tx would not validate anyway, but this is more consistent.
     if (chain_.is_blocks_stale())
-        return true;
+        return;
 
     if (message->metadata.originator == nonce())
-        return true;
+        return;
+
+    if (known_.contains(message->hash()))
+        return;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(announce_mutex_);
+
+    // Queued until the next announcement, duplicates are collapsed.
+    announcements_.emplace(message->hash(), rate);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Transactions announced by the peer are known to it, and are removed from
+// its announcement queue.
+bool protocol_transaction_out::handle_receive_inventory(const code& ec,
+    inventory_const_ptr message)
+{
+    if (stopped(ec))
+        return false;
+
+    for (const auto& inventory: message->inventories())
+        if (inventory.is_transaction_type())
+            known_.insert(inventory.hash());
 
-    // TODO: move fee_filter to a derived class protocol_transaction_out_70013.
-    if (message->fees() < minimum_peer_fee_)
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(announce_mutex_);
+
+    if (announcements_.empty())
         return true;
 
-    static const auto id = inventory::type_id::transaction;
-    const inventory announce{ { id, message->hash() } };
-    SEND2(announce, handle_send, _1, announce.command);
+    for (const auto& inventory: message->inventories())
+        if (inventory.is_transaction_type())
+            announcements_.erase(inventory.hash());
 
-    ////LOG_DEBUG(LOG_NODE)
-    ////    << "Announced tx [" << encode_hash(message->hash()) << "] to ["
-    ////    << authority() << "].";
     return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Announcement.
+//-----------------------------------------------------------------------------
+
+// Exponentially-distributed intervals make announcement times a Poisson
+// process, so timing does not reveal the order in which peers were sent a tx.
+// Announcements are flooded to every relay peer. Set reconciliation (BIP330)
+// cannot be negotiated, as its messages are not defined by the network layer.
+void protocol_transaction_out::schedule_announcements()
+{
+    std::exponential_distribution<double> distribution(
+        1.0 / announce_interval.count());
+
+    asio::milliseconds delay;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    announce_mutex_.lock();
+
+    delay = asio::milliseconds(static_cast<int64_t>(
+        distribution(generator_)));
+
+    announce_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    announce_timer_->start(BIND1(handle_announce, _1), delay);
+}
+
+void protocol_transaction_out::handle_announce(const code& ec)
+{
+    if (stopped(ec))
+        return;
+
+    typedef std::pair<uint64_t, hash_digest> rated_hash;
+    std::vector<rated_hash> batch;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    announce_mutex_.lock();
+
+    batch.reserve(announcements_.size());
+
+    for (const auto& entry: announcements_)
+        batch.emplace_back(entry.second, entry.first);
+
+    announcements_.clear();
+    announce_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Highest fee rate first, so that a peer requests those first.
+    std::sort(batch.begin(), batch.end(),
+        [](const rated_hash& left, const rated_hash& right)
+        {
+            return left.first > right.first;
+        });
+
+    static const auto id = inventory::type_id::transaction;
+
+    for (size_t start = 0; start < batch.size(); start += max_inventory)
+    {
+        const auto end = std::min(start + max_inventory, batch.size());
+        inventory announce;
+        announce.inventories().reserve(end - start);
+
+        for (auto index = start; index < end; ++index)
+        {
+            known_.insert(batch[index].second);
+            announce.inventories().emplace_back(id, batch[index].second);
+        }
+
+        SEND2(announce, handle_send, _1, announce.command);
+    }
+
+    schedule_announcements();
 }
 
 void protocol_transaction_out::handle_stop(const code&)
 {
-    chain_.unsubscribe();
+    relay_.unsubscribe(nonce());
+    announce_timer_->stop();
 
     LOG_VERBOSE(LOG_NODE)
         << "Stopped transaction_out protocol for [" << authority() << "].";
@@ -18,11 +18,13 @@
  */
 #include <bitcoin/node/sessions/session_inbound.hpp>
 
+#include <functional>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/full_node.hpp>
 #include <bitcoin/node/protocols/protocol_block_sync.hpp>
 #include <bitcoin/node/protocols/protocol_block_out.hpp>
+#include <bitcoin/node/protocols/protocol_filter_out.hpp>
 #include <bitcoin/node/protocols/protocol_header_in.hpp>
 #include <bitcoin/node/protocols/protocol_transaction_in.hpp>
 #include <bitcoin/node/protocols/protocol_transaction_out.hpp>
@@ -38,11 +40,24 @@ using namespace std::placeholders;
 session_inbound::session_inbound(full_node& network, safe_chain& chain)
   : session<network::session_inbound>(network, true),
     chain_(chain),
+    compact_filters_(network.node_settings().compact_filters),
+    phase_(network.phase()),
     CONSTRUCT_TRACK(node::session_inbound)
 {
 }
 
+// Channels attached while syncing are upgraded in place once current.
 void session_inbound::attach_protocols(channel::ptr channel)
+{
+    attach_sync_protocols(channel);
+
+    if (!phase_.defer(channel,
+        std::bind(&session_inbound::attach_relay_protocols,
+            this, _1)))
+        attach_relay_protocols(channel);
+}
+
+void session_inbound::attach_sync_protocols(channel::ptr channel)
 {
     const auto version = channel->negotiated_version();
 
@@ -57,11 +72,19 @@ void session_inbound::attach_protocols(channel::ptr channel)
     if (version >= version::level::headers)
         attach<protocol_header_in>(channel, chain_)->start();
 
-
     attach<protocol_block_sync>(channel, chain_)->start();
-    ////attach<protocol_block_out>(channel, chain_)->start();
-    ////attach<protocol_transaction_in>(channel, chain_)->start();
-    ////attach<protocol_transaction_out>(channel, chain_)->start();
+}
+
+void session_inbound::attach_relay_protocols(channel::ptr channel)
+{
+    attach<protocol_block_out>(channel, chain_)->start();
+    attach<protocol_transaction_in>(channel, chain_, false)->start();
+    attach<protocol_transaction_out>(channel, chain_)->start();
+
+    // Compact filters are served to (light client) inbound peers only.
+    if (compact_filters_)
+        attach<protocol_filter_out>(channel)->start();
+
     attach<protocol_address_31402>(channel)->start();
 }
 
@@ -18,6 +18,7 @@
  */
 #include <bitcoin/node/sessions/session_manual.hpp>
 
+#include <functional>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/full_node.hpp>
@@ -38,11 +39,23 @@ using namespace std::placeholders;
 session_manual::session_manual(full_node& network, safe_chain& chain)
   : session<network::session_manual>(network, true),
     chain_(chain),
+    phase_(network.phase()),
     CONSTRUCT_TRACK(node::session_manual)
 {
 }
 
+// Channels attached while syncing are upgraded in place once current.
 void session_manual::attach_protocols(channel::ptr channel)
+{
+    attach_sync_protocols(channel);
+
+    if (!phase_.defer(channel,
+        std::bind(&session_manual::attach_relay_protocols,
+            this, _1)))
+        attach_relay_protocols(channel);
+}
+
+void session_manual::attach_sync_protocols(channel::ptr channel)
 {
     const auto version = channel->negotiated_version();
 
@@ -58,9 +71,13 @@ void session_manual::attach_protocols(channel::ptr channel)
         attach<protocol_header_in>(channel, chain_)->start();
 
     attach<protocol_block_sync>(channel, chain_)->start();
-    ////attach<protocol_block_out>(channel, chain_)->start();
-    ////attach<protocol_transaction_in>(channel, chain_)->start();
-    ////attach<protocol_transaction_out>(channel, chain_)->start();
+}
+
+void session_manual::attach_relay_protocols(channel::ptr channel)
+{
+    attach<protocol_block_out>(channel, chain_)->start();
+    attach<protocol_transaction_in>(channel, chain_, true)->start();
+    attach<protocol_transaction_out>(channel, chain_)->start();
     attach<protocol_address_31402>(channel)->start();
 }
 
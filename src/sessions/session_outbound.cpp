@@ -18,6 +18,9 @@
  */
 #include <bitcoin/node/sessions/session_outbound.hpp>
 
+#include <cstddef>
+#include <functional>
+#include <memory>
 #include <bitcoin/blockchain.hpp>
 #include <bitcoin/network.hpp>
 #include <bitcoin/node/full_node.hpp>
@@ -35,14 +38,72 @@ using namespace bc::message;
 using namespace bc::network;
 using namespace std::placeholders;
 
+// The number of pooled addresses sampled for each outbound connection.
+// Sampling (not ranking the pool) retains randomness in peer selection.
+static constexpr size_t address_samples = 4;
+
 session_outbound::session_outbound(full_node& network, safe_chain& chain)
   : session<network::session_outbound>(network, true),
     chain_(chain),
+    history_(network.history()),
+    scaler_(network.scaler()),
+    phase_(network.phase()),
     CONSTRUCT_TRACK(node::session_outbound)
 {
 }
 
+// Start.
+//-----------------------------------------------------------------------------
+
+// The network runs a connection loop for each configured outbound connection.
+// Loops are added through the same path up to the sync ceiling, and all loops
+// above the target are parked in fetch_address, so network settings are not
+// changed.
+void session_outbound::start(result_handler handler)
+{
+    network::session_outbound::start(
+        std::bind(&session_outbound::handle_sync_started,
+            shared_from_base<session_outbound>(), _1, handler));
+}
+
+void session_outbound::handle_sync_started(const code& ec,
+    result_handler handler)
+{
+    if (!ec)
+    {
+        const auto configured = settings_.outbound_connections;
+        const auto ceiling = scaler_.ceiling();
+
+        for (auto loop = configured; loop < ceiling; ++loop)
+            new_connection(error::success);
+    }
+
+    handler(ec);
+}
+
+// Protocols.
+//-----------------------------------------------------------------------------
+
+// A channel above the outbound target is stopped, and its connection loop is
+// then parked in fetch_address until the target is raised. Channels attached
+// while syncing are upgraded in place once current.
 void session_outbound::attach_protocols(channel::ptr channel)
+{
+    if (!scaler_.attach(channel))
+    {
+        channel->stop(error::channel_stopped);
+        return;
+    }
+
+    attach_sync_protocols(channel);
+
+    if (!phase_.defer(channel,
+        std::bind(&session_outbound::attach_relay_protocols,
+            shared_from_base<session_outbound>(), _1)))
+        attach_relay_protocols(channel);
+}
+
+void session_outbound::attach_sync_protocols(channel::ptr channel)
 {
     const auto version = channel->negotiated_version();
 
@@ -58,11 +119,83 @@ void session_outbound::attach_protocols(channel::ptr channel)
         attach<protocol_header_in>(channel, chain_)->start();
 
     attach<protocol_block_sync>(channel, chain_)->start();
-    ////attach<protocol_block_out>(channel, chain_)->start();
-    ////attach<protocol_transaction_in>(channel, chain_)->start();
-    ////attach<protocol_transaction_out>(channel, chain_)->start();
+}
+
+void session_outbound::attach_relay_protocols(channel::ptr channel)
+{
+    attach<protocol_block_out>(channel, chain_)->start();
+    attach<protocol_transaction_in>(channel, chain_, true)->start();
+    attach<protocol_transaction_out>(channel, chain_)->start();
     attach<protocol_address_31402>(channel)->start();
 }
 
+// Address selection.
+//-----------------------------------------------------------------------------
+
+void session_outbound::fetch_address(host_handler handler) const
+{
+    scaler_.admit(
+        std::bind(&session_outbound::handle_admit,
+            std::static_pointer_cast<const session_outbound>(
+                shared_from_this()), _1, handler));
+}
+
+void session_outbound::handle_admit(const code& ec,
+    host_handler handler) const
+{
+    if (ec)
+    {
+        handler(ec, {});
+        return;
+    }
+
+    const auto state = std::make_shared<samples>();
+    state->remaining = address_samples;
+    state->result = error::address_not_found;
+    state->score = -1.0;
+
+    for (size_t sample = 0; sample < address_samples; ++sample)
+        network::session_outbound::fetch_address(
+            std::bind(&session_outbound::handle_fetch_address,
+                std::static_pointer_cast<const session_outbound>(
+                    shared_from_this()), _1, _2, state, handler));
+}
+
+// Peers without history score zero, so any peer with a measured download
+// rate is preferred to one without. A failed sample is used only if all fail.
+void session_outbound::handle_fetch_address(const code& ec,
+    const config::authority& host, samples_ptr state,
+    host_handler handler) const
+{
+    const auto score = ec ? -1.0 : history_.score(host);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    state->mutex.lock();
+
+    if (ec && state->score < 0.0)
+    {
+        state->result = ec;
+    }
+    else if (score > state->score)
+    {
+        state->result = error::success;
+        state->best = host;
+        state->score = score;
+    }
+
+    state->mutex.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (--state->remaining != 0)
+        return;
+
+    if (!state->result && state->score > 0.0)
+        LOG_DEBUG(LOG_NODE)
+            << "Selected peer [" << state->best << "] by download history.";
+
+    handler(state->result, state->best);
+}
+
 } // namespace node
 } // namespace libbitcoin
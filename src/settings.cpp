@@ -28,7 +28,14 @@ using namespace bc::asio;
 settings::settings()
   : maximum_deviation(1.5),
     block_latency_seconds(5),
-    refresh_transactions(false)
+    sync_outbound_connections(24),
+    download_budget_megabytes(1024),
+    download_lookahead_blocks(5000),
+    store_threads(0),
+    store_priority(false),
+    refresh_transactions(false),
+    upload_kilobytes_per_second(0),
+    compact_filters(false)
 {
 }
 
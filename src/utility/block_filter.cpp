@@ -0,0 +1,306 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/block_filter.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::chain;
+using namespace bc::machine;
+
+const uint8_t block_filter::basic_type = 0x00;
+const uint8_t block_filter::golomb_bits = 19;
+const uint64_t block_filter::inverse_rate = 784931;
+
+// The siphash key is the first half of the block hash.
+static siphash_key to_key(const hash_digest& block_hash)
+{
+    const auto k0 = from_little_endian_unsafe<uint64_t>(block_hash.begin());
+    const auto k1 = from_little_endian_unsafe<uint64_t>(block_hash.begin() +
+        sizeof(uint64_t));
+
+    return std::make_tuple(k0, k1);
+}
+
+// The high 64 bits of the 128 bit product, maps a hash into [0, range).
+static uint64_t map_to_range(uint64_t hash, uint64_t range)
+{
+    const uint64_t mask = 0xffffffff;
+    const auto hash_low = hash & mask;
+    const auto hash_high = hash >> 32;
+    const auto range_low = range & mask;
+    const auto range_high = range >> 32;
+
+    const auto low = hash_low * range_low;
+    const auto middle_one = hash_high * range_low;
+    const auto middle_two = hash_low * range_high;
+    const auto high = hash_high * range_high;
+    const auto carry = ((low >> 32) + (middle_one & mask) +
+        (middle_two & mask)) >> 32;
+
+    return high + (middle_one >> 32) + (middle_two >> 32) + carry;
+}
+
+// The sorted set of element hashes mapped into [0, count * inverse_rate).
+static std::vector<uint64_t> to_set(const data_stack& elements,
+    const hash_digest& block_hash)
+{
+    const auto key = to_key(block_hash);
+    const auto range = elements.size() * block_filter::inverse_rate;
+
+    std::vector<uint64_t> set;
+    set.reserve(elements.size());
+
+    for (const auto& element: elements)
+        set.push_back(map_to_range(siphash(key, element), range));
+
+    std::sort(set.begin(), set.end());
+    return set;
+}
+
+// Golomb-Rice coding.
+//-----------------------------------------------------------------------------
+
+// Bits are written most significant first.
+class bit_writer
+{
+public:
+    bit_writer(data_chunk& sink)
+      : sink_(sink), byte_(0), bits_(0)
+    {
+    }
+
+    void write(uint64_t value, uint8_t bits)
+    {
+        while (bits-- > 0)
+            write_bit(((value >> bits) & 1u) != 0);
+    }
+
+    void write_bit(bool bit)
+    {
+        byte_ = static_cast<uint8_t>((byte_ << 1) | (bit ? 1u : 0u));
+
+        if (++bits_ == byte_bits)
+            flush();
+    }
+
+    void flush()
+    {
+        if (bits_ == 0)
+            return;
+
+        sink_.push_back(static_cast<uint8_t>(byte_ << (byte_bits - bits_)));
+        byte_ = 0;
+        bits_ = 0;
+    }
+
+private:
+    data_chunk& sink_;
+    uint8_t byte_;
+    uint8_t bits_;
+};
+
+class bit_reader
+{
+public:
+    bit_reader(data_chunk::const_iterator begin,
+        data_chunk::const_iterator end)
+      : it_(begin), end_(end), bits_(0)
+    {
+    }
+
+    bool read(uint64_t& out, uint8_t bits)
+    {
+        out = 0;
+        for (auto bit = false; bits > 0; --bits)
+        {
+            if (!read_bit(bit))
+                return false;
+
+            out = (out << 1) | (bit ? 1u : 0u);
+        }
+
+        return true;
+    }
+
+    bool read_bit(bool& out)
+    {
+        if (it_ == end_)
+            return false;
+
+        out = ((*it_ >> (byte_bits - 1u - bits_)) & 1u) != 0;
+
+        if (++bits_ == byte_bits)
+        {
+            ++it_;
+            bits_ = 0;
+        }
+
+        return true;
+    }
+
+private:
+    data_chunk::const_iterator it_;
+    const data_chunk::const_iterator end_;
+    uint8_t bits_;
+};
+
+static void golomb_encode(bit_writer& writer, uint64_t value)
+{
+    for (auto quotient = value >> block_filter::golomb_bits; quotient > 0;
+        --quotient)
+        writer.write_bit(true);
+
+    writer.write_bit(false);
+    writer.write(value, block_filter::golomb_bits);
+}
+
+static bool golomb_decode(bit_reader& reader, uint64_t& out)
+{
+    uint64_t quotient = 0;
+    for (auto bit = true; ; ++quotient)
+    {
+        if (!reader.read_bit(bit))
+            return false;
+
+        if (!bit)
+            break;
+    }
+
+    uint64_t remainder;
+    if (!reader.read(remainder, block_filter::golomb_bits))
+        return false;
+
+    out = (quotient << block_filter::golomb_bits) | remainder;
+    return true;
+}
+
+// Filter.
+//-----------------------------------------------------------------------------
+
+// The set excludes empty and OP_RETURN output scripts and includes the
+// previous output script of every non-coinbase input, without duplicates.
+bool block_filter::compute(data_chunk& out_filter, const block& block)
+{
+    data_stack elements;
+
+    for (const auto& tx: block.transactions())
+    {
+        for (const auto& output: tx.outputs())
+        {
+            auto script = output.script().to_data(false);
+
+            if (!script.empty() &&
+                script.front() != static_cast<uint8_t>(opcode::return_))
+                elements.push_back(std::move(script));
+        }
+
+        if (tx.is_coinbase())
+            continue;
+
+        for (const auto& input: tx.inputs())
+        {
+            // Previous outputs are populated by block validation.
+            const auto& prevout = input.previous_output().metadata.cache;
+
+            if (!prevout.is_valid())
+                return false;
+
+            auto script = prevout.script().to_data(false);
+
+            if (!script.empty())
+                elements.push_back(std::move(script));
+        }
+    }
+
+    std::sort(elements.begin(), elements.end());
+    elements.erase(std::unique(elements.begin(), elements.end()),
+        elements.end());
+
+    const auto set = to_set(elements, block.hash());
+    out_filter.clear();
+    data_sink ostream(out_filter);
+    ostream_writer sink(ostream);
+    sink.write_variable_little_endian(set.size());
+    ostream.flush();
+
+    bit_writer writer(out_filter);
+
+    uint64_t previous = 0;
+    for (const auto value: set)
+    {
+        golomb_encode(writer, value - previous);
+        previous = value;
+    }
+
+    writer.flush();
+    return true;
+}
+
+hash_digest block_filter::to_header(const data_chunk& filter,
+    const hash_digest& previous_header)
+{
+    return bitcoin_hash(build_chunk({ bitcoin_hash(filter), previous_header }));
+}
+
+bool block_filter::contains(const data_chunk& filter,
+    const hash_digest& block_hash, const data_slice& element)
+{
+    data_source stream(filter);
+    istream_reader source(stream);
+    const auto count = source.read_variable_little_endian();
+
+    if (!source || count == 0)
+        return false;
+
+    const auto offset = message::variable_uint_size(count);
+    const auto target = map_to_range(siphash(to_key(block_hash), element),
+        count * inverse_rate);
+
+    bit_reader reader(filter.begin() + offset, filter.end());
+
+    uint64_t value = 0;
+    for (uint64_t index = 0; index < count; ++index)
+    {
+        uint64_t delta;
+        if (!golomb_decode(reader, delta))
+            return false;
+
+        value += delta;
+
+        if (value == target)
+            return true;
+
+        if (value > target)
+            return false;
+    }
+
+    return false;
+}
+
+} // namespace node
+} // namespace libbitcoin
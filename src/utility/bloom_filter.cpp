@@ -0,0 +1,357 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/bloom_filter.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::chain;
+using namespace bc::machine;
+
+const size_t bloom_filter::max_filter_bytes = 36000;
+const size_t bloom_filter::max_hash_functions = 50;
+const size_t bloom_filter::max_element_bytes = 520;
+
+// The BIP37 seed multiplier for the nth hash function.
+static constexpr uint32_t seed_factor = 0xfba4c795;
+
+// MurmurHash3 (x86_32) constants.
+static constexpr uint32_t c1 = 0xcc9e2d51;
+static constexpr uint32_t c2 = 0x1b873593;
+
+// A serialized output point (hash and little-endian index).
+typedef std::array<uint8_t, hash_size + sizeof(uint32_t)> point_bytes;
+
+inline uint32_t rotate_left(uint32_t value, uint8_t bits)
+{
+    return (value << bits) | (value >> (32u - bits));
+}
+
+inline uint32_t to_block(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0]) |
+        static_cast<uint32_t>(data[1]) << 8 |
+        static_cast<uint32_t>(data[2]) << 16 |
+        static_cast<uint32_t>(data[3]) << 24;
+}
+
+inline point_bytes to_point(const hash_digest& hash, uint32_t index)
+{
+    point_bytes point;
+    std::copy(hash.begin(), hash.end(), point.begin());
+
+    for (size_t byte = 0; byte < sizeof(uint32_t); ++byte)
+        point[hash_size + byte] = static_cast<uint8_t>(index >> (8u * byte));
+
+    return point;
+}
+
+// The data blocks are mixed once and then folded into every seed (lane) in
+// lockstep. The lane loops have no dependencies across lanes, so the k hash
+// functions of a bloom filter vectorize as a single pass over the element.
+static void murmur3_lanes(uint32_t* hashes, const uint32_t* seeds,
+    size_t lanes, const data_slice& data)
+{
+    const auto size = data.size();
+    const auto begin = data.data();
+    const auto blocks = size / 4u;
+
+    for (size_t lane = 0; lane < lanes; ++lane)
+        hashes[lane] = seeds[lane];
+
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        auto mix = to_block(begin + block * 4u);
+        mix *= c1;
+        mix = rotate_left(mix, 15);
+        mix *= c2;
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+            hashes[lane] = rotate_left(hashes[lane] ^ mix, 13) * 5u + 0xe6546b64;
+    }
+
+    const auto tail = begin + blocks * 4u;
+    const auto remainder = size & 3u;
+    uint32_t mix = 0;
+
+    // The tail bytes are mixed once, in descending order.
+    if (remainder == 3)
+        mix ^= static_cast<uint32_t>(tail[2]) << 16;
+
+    if (remainder >= 2)
+        mix ^= static_cast<uint32_t>(tail[1]) << 8;
+
+    if (remainder >= 1)
+    {
+        mix ^= static_cast<uint32_t>(tail[0]);
+        mix *= c1;
+        mix = rotate_left(mix, 15);
+        mix *= c2;
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+            hashes[lane] ^= mix;
+    }
+
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+        auto hash = hashes[lane] ^ static_cast<uint32_t>(size);
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6b;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35;
+        hash ^= hash >> 16;
+        hashes[lane] = hash;
+    }
+}
+
+// static
+uint32_t bloom_filter::murmur3(const data_slice& data, uint32_t seed)
+{
+    uint32_t hash;
+    murmur3_lanes(&hash, &seed, 1, data);
+    return hash;
+}
+
+bloom_filter::bloom_filter(const data_chunk& data, uint32_t hash_functions,
+    uint32_t tweak, uint8_t flags)
+  : data_(data),
+    hash_functions_(hash_functions),
+    flags_(flags)
+{
+    // Do not allocate seeds for an invalid filter.
+    if (!is_valid())
+        return;
+
+    seeds_.reserve(hash_functions_);
+
+    for (uint32_t function = 0; function < hash_functions_; ++function)
+        seeds_.push_back(function * seed_factor + tweak);
+}
+
+bool bloom_filter::is_valid() const
+{
+    return data_.size() <= max_filter_bytes &&
+        hash_functions_ <= max_hash_functions;
+}
+
+void bloom_filter::insert(const data_slice& element)
+{
+    if (data_.empty() || seeds_.empty())
+        return;
+
+    uint32_t bits[max_hash_functions];
+    indexes(bits, element);
+
+    for (size_t function = 0; function < seeds_.size(); ++function)
+        data_[bits[function] >> 3] |= (1u << (bits[function] & 7u));
+}
+
+bool bloom_filter::contains(const data_slice& element) const
+{
+    if (data_.empty() || seeds_.empty())
+        return false;
+
+    uint32_t bits[max_hash_functions];
+    indexes(bits, element);
+
+    for (size_t function = 0; function < seeds_.size(); ++function)
+        if ((data_[bits[function] >> 3] & (1u << (bits[function] & 7u))) == 0)
+            return false;
+
+    return true;
+}
+
+// protected
+void bloom_filter::indexes(uint32_t* out, const data_slice& element) const
+{
+    const auto width = static_cast<uint32_t>(data_.size() * byte_bits);
+    murmur3_lanes(out, seeds_.data(), seeds_.size(), element);
+
+    for (size_t function = 0; function < seeds_.size(); ++function)
+        out[function] %= width;
+}
+
+// Transactions are tested in block order so that outputs added to the filter
+// by update are matched by spends later in the same block.
+bloom_filter::matches bloom_filter::match(const block& block)
+{
+    const auto& transactions = block.transactions();
+    matches matched(transactions.size(), false);
+
+    for (size_t position = 0; position < transactions.size(); ++position)
+    {
+        const auto& tx = transactions[position];
+        matched[position] = match(tx, tx.hash());
+    }
+
+    return matched;
+}
+
+// protected
+bool bloom_filter::match(const transaction& tx, const hash_digest& hash)
+{
+    auto matched = contains(hash);
+    const auto& outputs = tx.outputs();
+
+    for (uint32_t index = 0; index < outputs.size(); ++index)
+    {
+        const auto& script = outputs[index].script();
+
+        for (const auto& operation: script.operations())
+        {
+            const auto& data = operation.data();
+
+            if (data.empty() || !contains(data))
+                continue;
+
+            matched = true;
+            const auto pattern = script.output_pattern();
+            const auto pay_key = pattern == script_pattern::pay_public_key ||
+                pattern == script_pattern::pay_multisig;
+
+            if (flags_ == update_all || (flags_ == update_p2pubkey_only &&
+                pay_key))
+                insert(to_point(hash, index));
+
+            break;
+        }
+    }
+
+    if (matched)
+        return true;
+
+    for (const auto& input: tx.inputs())
+    {
+        const auto& prevout = input.previous_output();
+
+        if (contains(to_point(prevout.hash(), prevout.index())))
+            return true;
+
+        for (const auto& operation: input.script().operations())
+        {
+            const auto& data = operation.data();
+
+            if (!data.empty() && contains(data))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+// Partial merkle tree.
+//-----------------------------------------------------------------------------
+
+struct partial_tree
+{
+    const hash_list& leaves;
+    const bloom_filter::matches& matched;
+    hash_list hashes;
+    std::vector<bool> bits;
+};
+
+// The number of tree nodes at the given height (leaves are height zero).
+inline size_t tree_width(size_t leaves, size_t height)
+{
+    return (leaves + (size_t{ 1 } << height) - 1u) >> height;
+}
+
+static hash_digest tree_hash(const partial_tree& tree, size_t height,
+    size_t position)
+{
+    if (height == 0)
+        return tree.leaves[position];
+
+    const auto left = tree_hash(tree, height - 1u, position * 2u);
+    const auto right = position * 2u + 1u < tree_width(tree.leaves.size(),
+        height - 1u) ? tree_hash(tree, height - 1u, position * 2u + 1u) : left;
+
+    return bitcoin_hash(build_chunk({ left, right }));
+}
+
+// Depth first traversal, descending only into subtrees containing a match.
+static void traverse(partial_tree& tree, size_t height, size_t position)
+{
+    const auto count = tree.leaves.size();
+    const auto begin = position << height;
+    const auto end = std::min((position + 1u) << height, count);
+
+    auto parent = false;
+    for (auto leaf = begin; leaf < end && !parent; ++leaf)
+        parent = tree.matched[leaf];
+
+    tree.bits.push_back(parent);
+
+    if (height == 0 || !parent)
+    {
+        tree.hashes.push_back(tree_hash(tree, height, position));
+        return;
+    }
+
+    traverse(tree, height - 1u, position * 2u);
+
+    if (position * 2u + 1u < tree_width(count, height - 1u))
+        traverse(tree, height - 1u, position * 2u + 1u);
+}
+
+// static
+message::merkle_block::ptr bloom_filter::to_merkle_block(const block& block,
+    const matches& matched)
+{
+    const auto& transactions = block.transactions();
+    const auto count = transactions.size();
+    BITCOIN_ASSERT(matched.size() == count);
+
+    hash_list leaves;
+    leaves.reserve(count);
+
+    for (const auto& tx: transactions)
+        leaves.push_back(tx.hash());
+
+    partial_tree tree{ leaves, matched, {}, {} };
+
+    size_t height = 0;
+    while (tree_width(count, height) > 1u)
+        ++height;
+
+    if (count != 0)
+        traverse(tree, height, 0);
+
+    // Flag bits are packed least significant bit first.
+    data_chunk flags((tree.bits.size() + 7u) / 8u, 0x00);
+
+    for (size_t bit = 0; bit < tree.bits.size(); ++bit)
+        if (tree.bits[bit])
+            flags[bit / 8u] |= (1u << (bit % 8u));
+
+    return std::make_shared<message::merkle_block>(block.header(), count,
+        tree.hashes, flags);
+}
+
+} // namespace node
+} // namespace libbitcoin
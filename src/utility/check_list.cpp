@@ -71,33 +71,19 @@ void check_list::push_back(hash_digest&& hash, size_t height)
     ///////////////////////////////////////////////////////////////////////////
 }
 
-void check_list::pop_back(const hash_digest& hash, size_t height)
+// Entries are height ordered, so removal proceeds from the back.
+size_t check_list::truncate(size_t fork_height)
 {
+    size_t count = 0;
+
     ///////////////////////////////////////////////////////////////////////////
     // Critical Section
-    mutex_.lock_upgrade();
-
-    if (checks_.empty() || checks_.back().hash() != hash)
-    {
-        mutex_.unlock_upgrade();
-        //---------------------------------------------------------------------
-        ////BITCOIN_ASSERT_MSG(false, "popped from empty list");
-        return;
-    }
-
-    if (checks_.back().height() != height)
-    {
-        mutex_.unlock_upgrade();
-        //---------------------------------------------------------------------
-        BITCOIN_ASSERT_MSG(false, "popped invalid height for hash");
-        return;
-    }
+    unique_lock lock(mutex_);
 
-    mutex_.unlock_upgrade_and_lock();
-    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    checks_.pop_back();
+    for (; !checks_.empty() && checks_.back().height() > fork_height; ++count)
+        checks_.pop_back();
 
-    mutex_.unlock();
+    return count;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -125,6 +111,26 @@ void check_list::push_front(hash_digest&& hash, size_t height)
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// Returned entries are typically near the top, so the search is from back.
+bool check_list::insert(hash_digest&& hash, size_t height)
+{
+    BITCOIN_ASSERT_MSG(height != 0, "inserted genesis height for download");
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    auto it = checks_.end();
+    for (; it != checks_.begin() && std::prev(it)->height() > height; --it);
+
+    if (it != checks_.begin() && std::prev(it)->height() == height)
+        return false;
+
+    checks_.emplace(it, std::move(hash), height);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 config::checkpoint check_list::pop_front()
 {
     ///////////////////////////////////////////////////////////////////////////
@@ -158,7 +164,9 @@ void check_list::advance(checks::iterator& it, size_t step)
         it = std::next(it), ++i);
 }
 
-check_list::checks check_list::extract(size_t divisor, size_t limit)
+// Entries are height ordered, so extraction ends at the first excluded.
+check_list::checks check_list::extract(size_t divisor, size_t limit,
+    size_t maximum_height)
 {
     if (divisor == 0 || limit == 0)
         return {};
@@ -168,7 +176,7 @@ check_list::checks check_list::extract(size_t divisor, size_t limit)
     mutex_.lock_upgrade();
 
     // Guard against empty initial list (loop safety).
-    if (checks_.empty())
+    if (checks_.empty() || checks_.front().height() > maximum_height)
     {
         mutex_.unlock_upgrade();
         //---------------------------------------------------------------------
@@ -181,8 +189,9 @@ check_list::checks check_list::extract(size_t divisor, size_t limit)
     checks result;
     const auto step = divisor - 1u;
 
-    for (auto it = checks_.begin();
-        it != checks_.end() && result.size() < limit; advance(it, step))
+    for (auto it = checks_.begin(); it != checks_.end() &&
+        it->height() <= maximum_height && result.size() < limit;
+        advance(it, step))
     {
         result.push_front(*it);
         it = checks_.erase(it);
@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/download_budget.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+// The weight of each imported block size in the moving size estimate.
+static constexpr double estimate_weight = 1.0 / 16.0;
+
+download_budget::download_budget(uint64_t bytes, size_t initial_estimate)
+  : capacity_(bytes),
+    outstanding_(0),
+    estimate_(static_cast<double>(std::max(initial_estimate, size_t{ 1 })))
+{
+}
+
+size_t download_budget::draw(size_t blocks, uint64_t& out_bytes)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto estimate = static_cast<uint64_t>(estimate_);
+    auto granted = blocks;
+
+    if (capacity_ != 0)
+    {
+        const auto available = capacity_ > outstanding_ ?
+            capacity_ - outstanding_ : 0;
+
+        granted = std::min<uint64_t>(blocks, available / estimate);
+
+        if (granted == 0 && outstanding_ == 0)
+            granted = std::min(blocks, size_t{ 1 });
+    }
+
+    out_bytes = granted * estimate;
+    outstanding_ += out_bytes;
+    return granted;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void download_budget::refund(uint64_t bytes)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    outstanding_ -= std::min(bytes, outstanding_);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void download_budget::record(size_t block_size)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    estimate_ += (static_cast<double>(block_size) - estimate_) *
+        estimate_weight;
+    estimate_ = std::max(estimate_, 1.0);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t download_budget::estimate() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return static_cast<size_t>(estimate_);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+uint64_t download_budget::outstanding() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return outstanding_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+double download_budget::utilization() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return divide<double>(outstanding_, capacity_);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,388 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/filter_index.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <boost/filesystem.hpp>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/block_filter.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::chain;
+using namespace std::chrono;
+
+// Block hash, filter hash, filter header and filter size precede the filter.
+static constexpr size_t record_size = 3u * hash_size + sizeof(uint32_t);
+typedef byte_array<record_size> record;
+
+filter_index::filter_index(const path& file)
+  : file_(file),
+    available_(false),
+    end_(0)
+{
+}
+
+// Startup.
+//-----------------------------------------------------------------------------
+
+bool filter_index::start()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    close();
+    end_ = 0;
+    entries_.clear();
+    heights_.clear();
+
+    // Opening the writer creates the file if missing.
+    boost::system::error_code ec;
+    if (!boost::filesystem::exists(file_, ec))
+        return open();
+
+    const auto file_size = boost::filesystem::file_size(file_, ec);
+    bc::ifstream file(file_.string(), std::ios::binary);
+
+    if (ec || file.bad())
+        return false;
+
+    record buffer;
+    hash_digest previous = null_hash;
+    const auto data = buffer.begin();
+
+    while (file.read(reinterpret_cast<char*>(buffer.data()), record_size))
+    {
+        entry next;
+        std::copy_n(data, hash_size, next.block_hash.begin());
+        std::copy_n(data + hash_size, hash_size, next.filter_hash.begin());
+        std::copy_n(data + 2u * hash_size, hash_size,
+            next.filter_header.begin());
+        next.size = from_little_endian_unsafe<uint32_t>(data +
+            3u * hash_size);
+        next.offset = end_;
+
+        // The file may end within a partially-written filter.
+        if (end_ + record_size + next.size > file_size)
+            break;
+
+        // A record not committing to its predecessor ends the index.
+        if (next.filter_header != bitcoin_hash(build_chunk(
+            { next.filter_hash, previous })))
+            break;
+
+        if (!file.seekg(next.size, std::ios::cur))
+            break;
+
+        previous = next.filter_header;
+        end_ += record_size + next.size;
+        heights_[next.block_hash] = entries_.size();
+        entries_.push_back(next);
+    }
+
+    file.close();
+
+    // Discard any partial or invalid trailing record.
+    boost::filesystem::resize_file(file_, end_, ec);
+    return !ec && open();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Must be called from within a unique lock.
+// The file is held open for the life of the index, so that pushes and
+// queries do not reopen it.
+bool filter_index::open()
+{
+    const auto path = file_.string();
+    writer_.reset(new bc::ofstream(path, std::ios::binary | std::ios::app));
+    reader_.reset(new bc::ifstream(path, std::ios::binary));
+    return writer_->good() && reader_->good();
+}
+
+// private
+// Must be called from within a unique lock.
+void filter_index::close()
+{
+    available_ = false;
+    writer_.reset();
+    reader_.reset();
+}
+
+// Properties.
+//-----------------------------------------------------------------------------
+
+size_t filter_index::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return entries_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool filter_index::available() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return available_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool filter_index::get_block_hash(hash_digest& out_hash, size_t height) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    if (height >= entries_.size())
+        return false;
+
+    out_hash = entries_[height].block_hash;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Indexing.
+//-----------------------------------------------------------------------------
+
+bool filter_index::catch_up(const block& block, size_t height,
+    size_t top_height)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (!writer_ || height > entries_.size())
+        return false;
+
+    if (height > 0u && block.header().previous_block_hash() !=
+        entries_[height - 1u].block_hash)
+        return false;
+
+    // A concurrent reorganization may have indexed the block.
+    if (height == entries_.size() || entries_[height].block_hash !=
+        block.hash())
+    {
+        available_ = false;
+
+        if (height == 0u)
+        {
+            end_ = 0;
+            entries_.clear();
+            heights_.clear();
+        }
+        else
+        {
+            pop_above(height - 1u);
+        }
+
+        boost::system::error_code ec;
+        boost::filesystem::resize_file(file_, end_, ec);
+
+        if (ec)
+            return false;
+
+        writer_->clear();
+
+        if (!push(block))
+            return false;
+    }
+
+    if (entries_.size() > top_height)
+        available_ = true;
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool filter_index::reorganize(size_t fork_height,
+    const block_const_ptr_list& incoming)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // The index cannot be extended across a gap, so it remains unavailable
+    // until a reorganization forks below its top.
+    available_ = false;
+
+    if (!writer_ || fork_height >= entries_.size())
+        return false;
+
+    pop_above(fork_height);
+
+    boost::system::error_code ec;
+    boost::filesystem::resize_file(file_, end_, ec);
+
+    if (ec)
+        return false;
+
+    // Clear any failure from a prior partial write, now truncated.
+    writer_->clear();
+
+    for (const auto block: incoming)
+        if (!push(*block))
+            return false;
+
+    available_ = true;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Must be called from within a unique lock.
+bool filter_index::push(const block& block)
+{
+    const auto start = steady_clock::now();
+
+    data_chunk filter;
+    if (!block_filter::compute(filter, block))
+        return false;
+
+    const auto elapsed = duration_cast<microseconds>(steady_clock::now() -
+        start);
+
+    const auto& previous = entries_.empty() ? null_hash :
+        entries_.back().filter_header;
+
+    entry next;
+    next.block_hash = block.hash();
+    next.filter_hash = bitcoin_hash(filter);
+    next.filter_header = block_filter::to_header(filter, previous);
+    next.offset = end_;
+    next.size = static_cast<uint32_t>(filter.size());
+
+    const auto buffer = build_chunk(
+    {
+        next.block_hash,
+        next.filter_hash,
+        next.filter_header,
+        to_little_endian(next.size),
+        filter
+    });
+
+    writer_->write(reinterpret_cast<const char*>(buffer.data()),
+        buffer.size());
+
+    // Flush so that the reader observes the filter.
+    if (!writer_->flush().good())
+        return false;
+
+    end_ += buffer.size();
+    heights_[next.block_hash] = entries_.size();
+    entries_.push_back(next);
+
+    LOG_DEBUG(LOG_NODE)
+        << "Filter [" << encode_hash(next.block_hash) << "] ("
+        << entries_.size() - 1u << ") of " << filter.size() << " bytes in "
+        << elapsed.count() << " us for "
+        << block.transactions().size() << " txs.";
+
+    return true;
+}
+
+// private
+// Must be called from within a unique lock.
+void filter_index::pop_above(size_t height)
+{
+    while (entries_.size() > height + 1u)
+    {
+        end_ = entries_.back().offset;
+        heights_.erase(entries_.back().block_hash);
+        entries_.pop_back();
+    }
+}
+
+// Queries.
+//-----------------------------------------------------------------------------
+
+bool filter_index::get_height(size_t& out_height,
+    const hash_digest& block_hash) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    const auto it = heights_.find(block_hash);
+
+    if (!available_ || it == heights_.end())
+        return false;
+
+    out_height = it->second;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool filter_index::get_hashes(hash_digest& out_block_hash,
+    hash_digest& out_filter_hash, hash_digest& out_filter_header,
+    size_t height) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    if (!available_ || height >= entries_.size())
+        return false;
+
+    const auto& entry = entries_[height];
+    out_block_hash = entry.block_hash;
+    out_filter_hash = entry.filter_hash;
+    out_filter_header = entry.filter_header;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool filter_index::get_filter(data_chunk& out_filter, size_t height) const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    if (!available_ || height >= entries_.size())
+        return false;
+
+    const auto& entry = entries_[height];
+
+    // The reader is shared, so its position is guarded separately.
+    unique_lock read_lock(reader_mutex_);
+
+    // Seeking discards buffered reads, which may precede a truncation.
+    reader_->clear();
+
+    if (!reader_->seekg(entry.offset + record_size))
+        return false;
+
+    out_filter.resize(entry.size);
+    return !!reader_->read(reinterpret_cast<char*>(out_filter.data()),
+        entry.size);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,197 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/orphan_pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+const size_t orphan_pool::max_orphan_bytes = 100000;
+
+orphan_pool::orphan_pool(size_t maximum_bytes, uint32_t expiry_seconds)
+  : maximum_bytes_(maximum_bytes),
+    expiry_(asio::seconds(expiry_seconds)),
+    bytes_(0)
+{
+}
+
+bool orphan_pool::store(transaction_const_ptr tx)
+{
+    const auto now = asio::steady_clock::now();
+    const auto size = tx->serialized_size(true);
+    const auto hash = tx->hash();
+    auto missing = tx->missing_previous_transactions();
+
+    if (size > max_orphan_bytes || missing.empty())
+        return false;
+
+    // Deduplicate parents so that each is indexed once.
+    std::sort(missing.begin(), missing.end());
+    missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (orphans_.find(hash) != orphans_.end())
+        return false;
+
+    for (const auto& parent: missing)
+        parents_.emplace(parent, hash);
+
+    const auto arrival = arrivals_.insert(arrivals_.end(), hash);
+    orphans_[hash] = { tx, std::move(missing), now + expiry_, arrival, size };
+    bytes_ += size;
+
+    evict(now);
+    return orphans_.find(hash) != orphans_.end();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+transaction_const_ptr_list orphan_pool::resolve(const hash_digest& parent)
+{
+    transaction_const_ptr_list out;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto range = parents_.equal_range(parent);
+
+    if (range.first == range.second)
+        return out;
+
+    hash_list ready;
+
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        auto& missing = orphans_[it->second].missing;
+        missing.erase(std::remove(missing.begin(), missing.end(), parent),
+            missing.end());
+
+        if (missing.empty())
+            ready.push_back(it->second);
+    }
+
+    parents_.erase(range.first, range.second);
+
+    // Arrival order is a valid topological order among independent orphans,
+    // their own descendants are resolved as each is accepted.
+    for (const auto& hash: arrivals_)
+    {
+        if (out.size() == ready.size())
+            break;
+
+        if (std::find(ready.begin(), ready.end(), hash) != ready.end())
+            out.push_back(orphans_[hash].tx);
+    }
+
+    for (const auto& hash: ready)
+        erase(hash);
+
+    return out;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void orphan_pool::remove(const hash_digest& hash)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    erase(hash);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t orphan_pool::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return orphans_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t orphan_pool::bytes() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return bytes_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// protected
+// Must be called from within a unique lock.
+void orphan_pool::erase(const hash_digest& hash)
+{
+    const auto it = orphans_.find(hash);
+
+    if (it == orphans_.end())
+        return;
+
+    const auto& entry = it->second;
+
+    // Remove the index entries of any parents still missing.
+    for (const auto& parent: entry.missing)
+    {
+        const auto range = parents_.equal_range(parent);
+
+        for (auto child = range.first; child != range.second; ++child)
+        {
+            if (child->second == hash)
+            {
+                parents_.erase(child);
+                break;
+            }
+        }
+    }
+
+    bytes_ -= entry.size;
+    arrivals_.erase(entry.arrival);
+    orphans_.erase(it);
+}
+
+// protected
+// Must be called from within a unique lock.
+void orphan_pool::evict(const asio::time_point& now)
+{
+    // Arrival order is expiry order, so expired orphans are at the front.
+    while (!arrivals_.empty() && orphans_[arrivals_.front()].expiry <= now)
+    {
+        const auto oldest = arrivals_.front();
+        erase(oldest);
+    }
+
+    while (bytes_ > maximum_bytes_ && !arrivals_.empty())
+    {
+        const auto oldest = arrivals_.front();
+        erase(oldest);
+    }
+}
+
+} // namespace node
+} // namespace libbitcoin
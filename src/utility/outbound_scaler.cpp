@@ -0,0 +1,248 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/outbound_scaler.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::network;
+using namespace std::placeholders;
+
+// The number of connections added by each increase.
+static constexpr size_t step = 2;
+
+// An increase must raise aggregate block rate by this fraction to continue.
+static constexpr double minimum_gain = 0.1;
+
+// The store is the bottleneck when it consumes this fraction of slot time.
+static constexpr double maximum_discount = 0.5;
+
+outbound_scaler::outbound_scaler(size_t steady, size_t ceiling,
+    uint32_t interval_seconds)
+  : steady_(steady),
+    ceiling_(std::max(steady, ceiling)),
+    interval_(asio::seconds(interval_seconds)),
+    stopped_(false),
+    growing_(true),
+    target_(steady),
+    previous_rate_(0),
+    updated_(asio::steady_clock::now())
+{
+}
+
+size_t outbound_scaler::ceiling() const
+{
+    return ceiling_;
+}
+
+size_t outbound_scaler::target() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return target_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t outbound_scaler::connected() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return channels_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void outbound_scaler::admit(admit_handler handler)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    if (stopped_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        handler(error::service_stopped);
+        return;
+    }
+
+    if (channels_.size() >= target_)
+    {
+        parked_.push_back(std::move(handler));
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    handler(error::success);
+}
+
+// Concurrent attempts may pass admission together, so the surplus is
+// rejected here and its connection loop returns to be parked.
+bool outbound_scaler::attach(channel::ptr channel)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    if (stopped_ || channels_.size() >= target_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return false;
+    }
+
+    channels_.push_back(channel);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    channel->subscribe_stop(std::bind(&outbound_scaler::handle_stop,
+        this, _1, channel->nonce()));
+
+    return true;
+}
+
+void outbound_scaler::update(double rate, double ratio, bool syncing)
+{
+    std::vector<admit_handler> admitted;
+    std::vector<channel::ptr> surplus;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    const auto now = asio::steady_clock::now();
+
+    if (stopped_ || now - updated_ < interval_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    updated_ = now;
+    const auto previous = target_;
+    target_ = next_target(rate, ratio, syncing);
+
+    if (target_ != previous)
+        LOG_INFO(LOG_NODE)
+            << "Outbound connection target changed from (" << previous
+            << ") to (" << target_ << ").";
+
+    // Release parked attempts up to the new target.
+    while (!parked_.empty() && channels_.size() + admitted.size() < target_)
+    {
+        admitted.push_back(std::move(parked_.back()));
+        parked_.pop_back();
+    }
+
+    // Stop the most recent channels above the target.
+    for (auto it = channels_.rbegin();
+        it != channels_.rend() && channels_.size() - surplus.size() > target_;
+        ++it)
+        surplus.push_back(*it);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& handler: admitted)
+        handler(error::success);
+
+    for (const auto channel: surplus)
+        channel->stop(error::channel_stopped);
+}
+
+void outbound_scaler::stop()
+{
+    std::vector<admit_handler> parked;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    stopped_ = true;
+    std::swap(parked, parked_);
+    channels_.clear();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& handler: parked)
+        handler(error::service_stopped);
+}
+
+// protected
+size_t outbound_scaler::next_target(double rate, double ratio, bool syncing)
+{
+    // Growth may resume on the next sync (e.g. after a long disconnect).
+    if (!syncing)
+    {
+        growing_ = true;
+        previous_rate_ = 0;
+        return steady_;
+    }
+
+    // The store is the bottleneck, so added peers would not add throughput.
+    if (ratio >= maximum_discount)
+    {
+        growing_ = false;
+        return target_;
+    }
+
+    // The last increase did not raise throughput enough to continue.
+    if (target_ != steady_ && rate < previous_rate_ * (1.0 + minimum_gain))
+        growing_ = false;
+
+    previous_rate_ = rate;
+    return growing_ ? std::min(target_ + step, ceiling_) : target_;
+}
+
+// protected
+void outbound_scaler::handle_stop(const code&, uint64_t nonce)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    channels_.remove_if([nonce](const channel::ptr& channel)
+    {
+        return channel->nonce() == nonce;
+    });
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace node
+} // namespace libbitcoin
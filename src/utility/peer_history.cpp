@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/peer_history.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+// The weight of a new channel measurement in the smoothed history.
+static constexpr double smoothing = 0.25;
+
+inline double smooth(double history, double sample)
+{
+    return history + smoothing * (sample - history);
+}
+
+peer_history::peer_history(const path& file, size_t capacity)
+  : file_(file),
+    capacity_(std::max(capacity, size_t(1)))
+{
+}
+
+// One line per peer: authority rate latency stalls reason.
+bool peer_history::load()
+{
+    boost::system::error_code ec;
+
+    if (!boost::filesystem::exists(file_, ec))
+        return true;
+
+    bc::ifstream file(file_.string());
+
+    if (file.bad())
+        return false;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    std::string line;
+    while (std::getline(file, line) && entries_.size() < capacity_)
+    {
+        std::istringstream reader(line);
+        std::string peer;
+        entry value;
+
+        if (reader >> peer >> value.rate >> value.latency >> value.stalls >>
+            value.reason)
+            entries_[peer] = value;
+    }
+
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool peer_history::save() const
+{
+    bc::ofstream file(file_.string(), std::ios::trunc);
+
+    if (file.bad())
+        return false;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    for (const auto& pair: entries_)
+    {
+        const auto& value = pair.second;
+        file << pair.first << " " << value.rate << " " << value.latency << " "
+            << value.stalls << " " << value.reason << std::endl;
+    }
+
+    return !file.bad();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void peer_history::record(const config::authority& peer, double rate,
+    uint32_t latency_milliseconds, bool stalled, const code& reason)
+{
+    const auto key = peer.to_string();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = entries_.find(key);
+
+    if (it == entries_.end())
+    {
+        if (entries_.size() >= capacity_)
+            evict();
+
+        entries_[key] = { rate, latency_milliseconds, stalled ? 1u : 0u,
+            reason.value() };
+        return;
+    }
+
+    auto& value = it->second;
+
+    // A zero measurement means the channel did not download (or request).
+    if (rate > 0)
+        value.rate = smooth(value.rate, rate);
+
+    if (latency_milliseconds > 0)
+        value.latency = static_cast<uint32_t>(smooth(value.latency,
+            latency_milliseconds));
+
+    if (stalled)
+        ++value.stalls;
+
+    value.reason = reason.value();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool peer_history::find(entry& out_entry, const config::authority& peer) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    const auto it = entries_.find(peer.to_string());
+
+    if (it == entries_.end())
+        return false;
+
+    out_entry = it->second;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+double peer_history::score(const config::authority& peer) const
+{
+    entry value;
+    return find(value, peer) ? to_score(value) : 0.0;
+}
+
+size_t peer_history::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return entries_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+// Each stall further discounts the historical rate.
+double peer_history::to_score(const entry& value)
+{
+    return value.rate / (1.0 + value.stalls);
+}
+
+// private
+void peer_history::evict()
+{
+    const auto lowest = std::min_element(entries_.begin(), entries_.end(),
+        [](const entries::value_type& left, const entries::value_type& right)
+        {
+            return to_score(left.second) < to_score(right.second);
+        });
+
+    if (lowest != entries_.end())
+        entries_.erase(lowest);
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,223 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/pool_index.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::chain;
+
+// No transaction hash is null, so this precedes every entry.
+const pool_index::cursor pool_index::first{ max_uint64, null_hash };
+
+// static
+uint64_t pool_index::fee_rate(const transaction& tx)
+{
+    return fee_rate(tx.fees(), tx.serialized_size(false));
+}
+
+// static
+uint64_t pool_index::fee_rate(uint64_t fees, size_t size)
+{
+    return fees * 1000u / std::max(size, size_t(1));
+}
+
+pool_index::pool_index(size_t maximum_entries, size_t maximum_streams)
+  : maximum_entries_(std::max(maximum_entries, size_t(1))),
+    maximum_streams_(maximum_streams),
+    streams_(0),
+    sequence_(0)
+{
+}
+
+void pool_index::insert(const hash_digest& hash, uint64_t rate)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = hashes_.find(hash);
+
+    if (it != hashes_.end())
+    {
+        rates_.erase({ it->second.first, hash });
+        hashes_.erase(it);
+    }
+
+    emplace(hash, rate);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void pool_index::remove(const hash_digest& hash)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = hashes_.find(hash);
+
+    if (it == hashes_.end())
+        return;
+
+    rates_.erase({ it->second.first, hash });
+    hashes_.erase(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The pool does not publish evictions, expirations, conflicts or the return
+// of transactions from outgoing blocks, so the index follows its pages.
+// A page is not the whole pool, so entries absent from it are retained.
+hash_list pool_index::synchronize(const hash_list& pooled)
+{
+    hash_list unindexed;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    for (const auto& hash: pooled)
+    {
+        const auto it = hashes_.find(hash);
+
+        if (it == hashes_.end())
+            unindexed.push_back(hash);
+        else
+            it->second.second = sequence_++;
+    }
+
+    return unindexed;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Called once all pages of a pool read that began at the sequence are marked.
+size_t pool_index::sweep(uint64_t sequence)
+{
+    size_t count = 0;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    for (auto it = hashes_.begin(); it != hashes_.end();)
+    {
+        if (it->second.second >= sequence)
+        {
+            ++it;
+            continue;
+        }
+
+        rates_.erase({ it->second.first, it->first });
+        it = hashes_.erase(it);
+        ++count;
+    }
+
+    return count;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+uint64_t pool_index::sequence() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return sequence_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t pool_index::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return rates_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Entries inserted or removed between pages do not invalidate the cursor.
+pool_index::cursor pool_index::page(hash_list& out, const cursor& after,
+    uint64_t minimum_rate, size_t limit) const
+{
+    auto last = after;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    for (auto it = rates_.upper_bound(after); it != rates_.end() &&
+        it->first >= minimum_rate && limit > 0; ++it, --limit)
+    {
+        out.push_back(it->second);
+        last = *it;
+    }
+
+    return last;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool pool_index::open_stream()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (streams_ >= maximum_streams_)
+        return false;
+
+    ++streams_;
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void pool_index::close_stream()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    BITCOIN_ASSERT(streams_ > 0);
+    --streams_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// private
+void pool_index::emplace(const hash_digest& hash, uint64_t rate)
+{
+    hashes_.emplace(hash, position{ rate, sequence_++ });
+    rates_.insert({ rate, hash });
+
+    // Evict the lowest fee rate entry (possibly this one).
+    if (rates_.size() > maximum_entries_)
+    {
+        const auto lowest = std::prev(rates_.end());
+        hashes_.erase(lowest->second);
+        rates_.erase(lowest);
+    }
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/relay_buckets.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+// Bucket lower bounds (satoshis per kilobyte) grow by about ten percent.
+static constexpr uint64_t maximum_bound = 100000000;
+
+static std::vector<uint64_t> make_bounds()
+{
+    std::vector<uint64_t> bounds{ 0 };
+
+    for (uint64_t bound = 1; bound <= maximum_bound;
+        bound = std::max(bound + 1u, bound * 11u / 10u))
+        bounds.push_back(bound);
+
+    return bounds;
+}
+
+static const std::vector<uint64_t> bounds = make_bounds();
+
+// static
+size_t relay_buckets::to_bucket(uint64_t rate)
+{
+    const auto it = std::upper_bound(bounds.begin(), bounds.end(), rate);
+    return static_cast<size_t>(std::distance(bounds.begin(), it)) - 1u;
+}
+
+relay_buckets::relay_buckets()
+  : buckets_(bounds.size())
+{
+}
+
+void relay_buckets::subscribe(uint64_t channel, uint64_t minimum_rate,
+    relay_handler handler)
+{
+    const auto bucket = to_bucket(minimum_rate);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = channels_.find(channel);
+
+    if (it != channels_.end())
+    {
+        buckets_[it->second].erase(channel);
+        it->second = bucket;
+    }
+    else
+    {
+        channels_.emplace(channel, bucket);
+    }
+
+    buckets_[bucket][channel] = { minimum_rate, std::move(handler) };
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool relay_buckets::update(uint64_t channel, uint64_t minimum_rate)
+{
+    const auto bucket = to_bucket(minimum_rate);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = channels_.find(channel);
+
+    if (it == channels_.end())
+        return false;
+
+    auto& from = buckets_[it->second];
+    const auto entry = from.find(channel);
+    auto handler = std::move(entry->second.handler);
+    from.erase(entry);
+
+    it->second = bucket;
+    buckets_[bucket][channel] = { minimum_rate, std::move(handler) };
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void relay_buckets::unsubscribe(uint64_t channel)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    const auto it = channels_.find(channel);
+
+    if (it == channels_.end())
+        return;
+
+    buckets_[it->second].erase(channel);
+    channels_.erase(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void relay_buckets::relay(transaction_const_ptr tx, uint64_t rate)
+{
+    const auto top = to_bucket(rate);
+    std::vector<relay_handler> handlers;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_shared();
+
+    // The filter of a subscriber below the transaction bucket is less than
+    // the bucket bound, so only the top bucket requires a fee rate compare.
+    for (size_t bucket = 0; bucket < top; ++bucket)
+        for (const auto& entry: buckets_[bucket])
+            handlers.push_back(entry.second.handler);
+
+    for (const auto& entry: buckets_[top])
+        if (entry.second.minimum_rate <= rate)
+            handlers.push_back(entry.second.handler);
+
+    mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& handler: handlers)
+        handler(tx, rate);
+}
+
+void relay_buckets::stop()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    for (auto& bucket: buckets_)
+        bucket.clear();
+
+    channels_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t relay_buckets::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return channels_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace node
+} // namespace libbitcoin
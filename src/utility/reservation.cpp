@@ -18,10 +18,12 @@
  */
 #include <bitcoin/node/utility/reservation.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <iterator>
 #include <utility>
 #include <boost/format.hpp>
 #include <bitcoin/bitcoin.hpp>
@@ -43,8 +45,14 @@ static constexpr size_t micro_per_second = 1000 * 1000;
 
 reservation::reservation(reservations& reservations, size_t slot,
     float maximum_deviation, uint32_t block_latency_seconds)
-  : stopped_(true),
+  : urgent_pending_(false),
+    channel_(0),
+    boundary_(0),
+    credits_(0),
+    drawn_(0),
+    stopped_(true),
     pending_(false),
+    woken_(false),
     reservations_(reservations),
     slot_(slot),
     maximum_deviation_(maximum_deviation),
@@ -54,17 +62,51 @@ reservation::reservation(reservations& reservations, size_t slot,
 {
 }
 
+// A partitioned row may be reassigned before its channel has stopped, so the
+// prior channel's waker and credit are released here.
 void reservation::start()
 {
+    refund();
+    set_waker(0, nullptr);
     stopped_ = false;
     pending_ = true;
     idle_limit_.store(asio::steady_clock::now() + rate_window_);
 }
 
-void reservation::stop()
+// The row is stopped only by its assigned channel, as it may be reassigned.
+void reservation::stop(uint64_t channel)
+{
+    if (this->channel() != channel)
+        return;
+
+    stop(true);
+    refund();
+    set_waker(0, nullptr);
+}
+
+// External callers will invoke the lock, but partition cannot.
+// The waker and credit are retained for the channel, which is still running.
+void reservation::stop(bool lock)
 {
     stopped_ = true;
     reset();
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    hash_mutex_.lock();
+
+    const auto urgent = urgent_;
+    urgent_.clear();
+    released_.clear();
+    expedited_.clear();
+    urgent_pending_ = false;
+
+    hash_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Expedited hashes are not partitioned, so return them for reservation.
+    for (const auto& entry: urgent.left)
+        reservations_.abandon(entry.first, entry.second, lock);
 }
 
 bool reservation::stopped() const
@@ -72,6 +114,47 @@ bool reservation::stopped() const
     return stopped_;
 }
 
+// The waker retains the channel protocol, so it is cleared on stop.
+void reservation::set_waker(uint64_t channel, result_handler handler)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(hash_mutex_);
+
+    channel_ = channel;
+    waker_ = std::move(handler);
+    woken_ = false;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+uint64_t reservation::channel() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(hash_mutex_);
+
+    return channel_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Wakeups are coalesced until the next request, so that a burst of header
+// reindexations results in at most one pending request evaluation.
+void reservation::wake()
+{
+    if (woken_.exchange(true))
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    hash_mutex_.lock_shared();
+    const auto waker = waker_;
+    hash_mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (waker)
+        waker(error::success);
+}
+
 size_t reservation::slot() const
 {
     return slot_;
@@ -206,6 +289,53 @@ void reservation::update_history(size_t events,
     set_rate(std::move(rate));
 }
 
+// Credit methods.
+//-----------------------------------------------------------------------------
+
+// protected
+void reservation::settle(size_t height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    hash_mutex_.lock();
+
+    // Expedited blocks are requested without credit.
+    if (expedited_.erase(height) != 0 || credits_ == 0 || height > boundary_)
+    {
+        hash_mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    // Each block returns the average of the credit drawn for the row.
+    const auto bytes = drawn_ / credits_;
+    drawn_ -= bytes;
+    --credits_;
+
+    hash_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    reservations_.budget().refund(bytes);
+}
+
+// protected
+void reservation::refund()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    hash_mutex_.lock();
+
+    const auto bytes = drawn_;
+    boundary_ = 0;
+    credits_ = 0;
+    drawn_ = 0;
+
+    hash_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    reservations_.budget().refund(bytes);
+}
+
 // Hash methods.
 //-----------------------------------------------------------------------------
 
@@ -215,7 +345,7 @@ bool reservation::empty() const
     ///////////////////////////////////////////////////////////////////////////
     shared_lock lock(hash_mutex_);
 
-    return heights_.empty();
+    return heights_.empty() && urgent_.empty();
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -225,7 +355,19 @@ size_t reservation::size() const
     ///////////////////////////////////////////////////////////////////////////
     shared_lock lock(hash_mutex_);
 
-    return heights_.size();
+    return heights_.size() + urgent_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Expedited blocks draw no credit, but are requested once the pending request
+// is sent, so a stalled race is detected by the slot deadline.
+size_t reservation::requested() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(hash_mutex_);
+
+    return credits_ + (urgent_pending_ ? 0 : urgent_.size());
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -241,8 +383,14 @@ void reservation::insert(config::checkpoint&& check)
 }
 
 // Obtain and clear the outstanding blocks request.
+// Credit is drawn as blocks are requested, lowest height first, so that all
+// requested blocks are at or below the boundary height. The request remains
+// pending while it is throttled by the download budget.
 message::get_data reservation::request()
 {
+    // Subsequent wakeups are evaluated by a subsequent request.
+    woken_ = false;
+
     if (stopped())
         return {};
 
@@ -261,19 +409,38 @@ message::get_data reservation::request()
         return {};
     }
 
-    message::get_data packet;
+    // Without outstanding credit no hash in the row has been requested.
     const auto& right = heights_.right;
+    const auto first = right.upper_bound(credits_ == 0 ? 0 : boundary_);
+    const auto wanted = static_cast<size_t>(std::distance(first, right.end()));
+
+    uint64_t bytes;
+    const auto granted = reservations_.budget().draw(wanted, bytes);
+
+    message::get_data packet;
+    auto boundary = boundary_;
+    auto height = first;
+    static const auto id = message::inventory::type_id::block;
+
+    // Expedited blocks are requested first and only once.
+    if (urgent_pending_)
+        for (const auto& entry: urgent_.left)
+            packet.inventories().emplace_back(id, entry.first);
 
     // Build get_blocks request message.
-    for (auto height = right.begin(); height != right.end(); ++height)
+    for (size_t block = 0; block < granted; ++block, ++height)
     {
-        static const auto id = message::inventory::type_id::block;
         packet.inventories().emplace_back(id, height->second);
+        boundary = height->first;
     }
 
     hash_mutex_.unlock_upgrade_and_lock();
     //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-    pending_ = false;
+    boundary_ = boundary;
+    credits_ += granted;
+    drawn_ += bytes;
+    pending_ = granted < wanted;
+    urgent_pending_ = false;
 
     hash_mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
@@ -296,6 +463,33 @@ bool reservation::find_height_and_erase(const hash_digest& hash,
     hash_mutex_.lock_upgrade();
 
     const auto it = heights_.left.find(hash);
+    const auto urgent = urgent_.left.find(hash);
+
+    // An expedited block is imported without settling credit, unless it has
+    // been claimed by another slot in a download race.
+    if (it == heights_.left.end() && urgent != urgent_.left.end())
+    {
+        out_height = urgent->second;
+        hash_mutex_.unlock_upgrade_and_lock();
+        //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+        urgent_.left.erase(urgent);
+        hash_mutex_.unlock();
+        //---------------------------------------------------------------------
+
+        const auto claimed = reservations_.claim(hash, slot_);
+
+        // Critical Section
+        ///////////////////////////////////////////////////////////////////////
+        unique_lock lock(hash_mutex_);
+
+        if (claimed)
+            expedited_.insert(out_height);
+        else
+            released_.insert(hash);
+
+        return claimed;
+        ///////////////////////////////////////////////////////////////////////
+    }
 
     if (it == heights_.left.end())
     {
@@ -330,6 +524,146 @@ bool reservation::find_height_and_erase(const hash_digest& hash,
     return true;
 }
 
+bool reservation::contains(size_t height) const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(hash_mutex_);
+
+    return heights_.right.find(height) != heights_.right.end() ||
+        urgent_.right.find(height) != urgent_.right.end();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The block may already be requested, in which case its credit is returned.
+// An expedited block holds no credit, and may be expedited again from here.
+bool reservation::release(size_t height, config::checkpoint& out_check)
+{
+    uint64_t bytes = 0;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    hash_mutex_.lock();
+
+    const auto it = heights_.right.find(height);
+
+    if (it == heights_.right.end())
+    {
+        const auto urgent = urgent_.right.find(height);
+        const auto found = urgent != urgent_.right.end();
+
+        if (found)
+        {
+            out_check = { urgent->second, height };
+
+            // Expedited hashes are requested once the pending request is sent.
+            if (!urgent_pending_)
+                released_.insert(urgent->second);
+
+            urgent_.right.erase(urgent);
+        }
+
+        hash_mutex_.unlock();
+        //---------------------------------------------------------------------
+        return found;
+    }
+
+    out_check = { it->second, height };
+    released_.insert(it->second);
+    heights_.right.erase(it);
+
+    if (credits_ != 0 && height <= boundary_)
+    {
+        bytes = drawn_ / credits_;
+        drawn_ -= bytes;
+        --credits_;
+    }
+
+    hash_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    reservations_.budget().refund(bytes);
+    return true;
+}
+
+bool reservation::find_released_and_erase(const hash_digest& hash)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(hash_mutex_);
+
+    return released_.erase(hash) != 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void reservation::expedite(config::checkpoint&& check)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(hash_mutex_);
+
+    pending_ = true;
+    urgent_pending_ = true;
+    urgent_.insert({ std::move(check.hash()), check.height() });
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Hashes are height indexed, so all above the fork are removed as one range.
+size_t reservation::invalidate(size_t fork_height)
+{
+    uint64_t bytes = 0;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    hash_mutex_.lock();
+
+    const auto first = heights_.right.upper_bound(fork_height);
+    const auto urgent = urgent_.right.upper_bound(fork_height);
+    const auto count = std::distance(first, heights_.right.end()) +
+        std::distance(urgent, urgent_.right.end());
+
+    for (auto it = first; it != heights_.right.end(); ++it)
+    {
+        if (credits_ == 0 || it->first > boundary_)
+            break;
+
+        bytes += drawn_ / credits_;
+        drawn_ -= drawn_ / credits_;
+        released_.insert(it->second);
+        --credits_;
+    }
+
+    // Expedited hashes are requested once the pending request is sent.
+    for (auto it = urgent; it != urgent_.right.end(); ++it)
+        if (!urgent_pending_)
+            released_.insert(it->second);
+
+    heights_.right.erase(first, heights_.right.end());
+    urgent_.right.erase(urgent, urgent_.right.end());
+    boundary_ = std::min(boundary_, fork_height);
+
+    hash_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    reservations_.budget().refund(bytes);
+    return static_cast<size_t>(count);
+}
+
+bool reservation::withdraw(const hash_digest& hash)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(hash_mutex_);
+
+    if (urgent_.left.erase(hash) == 0)
+        return false;
+
+    // The hash may have been requested, so its arrival is expected.
+    released_.insert(hash);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
 code reservation::import(safe_chain& chain, block_const_ptr block,
     size_t height)
 {
@@ -345,6 +679,9 @@ code reservation::import(safe_chain& chain, block_const_ptr block,
     const auto ec = chain.organize(block, height);
     //#########################################################################
 
+    // The block is no longer buffered, so its credit is returned.
+    settle(height);
+
     if (ec)
     {
         LOG_ERROR(LOG_NODE)
@@ -358,6 +695,7 @@ code reservation::import(safe_chain& chain, block_const_ptr block,
     // Recompute rate performance.
     auto size = block->serialized_size(message::version::level::canonical);
     auto time = std::chrono::duration_cast<asio::microseconds>(now() - start);
+    reservations_.budget().record(size);
 
     // Update history data for computing peer performance standard deviation.
     update_history(size, time);
@@ -366,16 +704,20 @@ code reservation::import(safe_chain& chain, block_const_ptr block,
     // Only log performance every ~10th block, until ~one day left.
     if (remaining < 144 || height % 10 == 0)
     {
-        // Block #height (slot) [hash] Mbps local-cost% remaining-blocks.
-        static const auto form = "Block #%06i (%02i) [%s] %07.3f %05.2f%% %i";
+        // Block #height (slot) [hash] Mbps local-cost% remaining-blocks
+        // budget-used%.
+        static const auto form =
+            "Block #%06i (%02i) [%s] %07.3f %05.2f%% %i %05.2f%%";
         const auto record = rate();
         const auto encoded = encode_hash(block->hash());
         const auto database_percentage = record.ratio() * 100;
+        const auto budget_percentage =
+            reservations_.budget().utilization() * 100;
 
         LOG_INFO(LOG_NODE)
             << boost::format(form) % height % slot() % encoded %
             performance::to_megabits_per_second(record.rate()) %
-            database_percentage % remaining;
+            database_percentage % remaining % budget_percentage;
     }
 
     return error::success;
@@ -414,14 +756,19 @@ bool reservation::partition(reservation::ptr minimal)
     // The maximal reservation is partitioned if it has been reduced.
     // Stop the channel so we stop accepting previously-requested blocks.
     if (populated)
-    {
         minimal->pending_ = true;
-        stop();
-    }
 
     hash_mutex_.unlock_shared();
     ///////////////////////////////////////////////////////////////////////////
 
+    // Partition is called under the reservation table lock. The channel is
+    // woken so that it restarts without waiting for its deadline.
+    if (populated)
+    {
+        stop(false);
+        wake();
+    }
+
     return populated;
 }
 
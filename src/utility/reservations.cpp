@@ -21,8 +21,10 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <iterator>
 #include <memory>
 #include <numeric>
+#include <string>
 #include <utility>
 #include <vector>
 #include <bitcoin/bitcoin.hpp>
@@ -38,25 +40,73 @@ namespace node {
 using namespace bc::blockchain;
 using namespace bc::chain;
 
+// Simple conversion factor, since the budget is configured in megabytes.
+static constexpr uint64_t bytes_per_megabyte = 1024 * 1024;
+
+// Requests are budgeted at the maximum block size until blocks are imported.
+static constexpr size_t initial_block_estimate = max_block_size;
+
+// Announced blocks are raced to the announcer while the queue is this shallow.
+static constexpr size_t maximum_direct_queue = 16;
+
+// Unreindexed announcements are discarded beyond this number.
+static constexpr size_t maximum_announcements = 64;
+
 reservations::reservations(size_t minimum_peer_count, float maximum_deviation,
-    uint32_t block_latency_seconds)
-  : max_request_(max_get_data),
+    uint32_t block_latency_seconds, uint32_t download_budget_megabytes,
+    uint32_t download_lookahead_blocks)
+  : budget_(download_budget_megabytes * bytes_per_megabyte,
+        initial_block_estimate),
+    max_request_(max_get_data),
     minimum_peer_count_(minimum_peer_count),
     block_latency_seconds_(block_latency_seconds),
     maximum_deviation_(maximum_deviation),
-    initialized_(false)
+    lookahead_(download_lookahead_blocks),
+    initialized_(false),
+    frontier_(0),
+    validated_(0),
+    frontier_since_(asio::steady_clock::now())
 {
 }
 
-void reservations::pop_back( chain::header& header, size_t height)
+// Hashes of a reorganized branch may be reserved or requested in any row.
+void reservations::invalidate(size_t fork_height)
 {
-    hashes_.pop_back(header.hash(), height);
+    auto count = hashes_.truncate(fork_height);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_upgrade();
+
+    for (const auto row: table_)
+        count += row->invalidate(fork_height);
+
+    mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    validated_ = std::min(validated_, fork_height);
+
+    // Racing slots no longer hold hashes above the fork.
+    for (auto it = races_.begin(); it != races_.end();)
+        it = it->second.height > fork_height ? races_.erase(it) : std::next(it);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (count != 0)
+        LOG_DEBUG(LOG_NODE)
+            << "Invalidated (" << count << ") block downloads above fork ["
+            << fork_height << "].";
 }
 
 void reservations::push_back( chain::header& header, size_t height)
 {
-    if (!header.metadata.populated)
-        hashes_.push_back(header.hash(), height);
+    if (header.metadata.populated)
+        return;
+
+    auto hash = header.hash();
+
+    if (!race(hash, height))
+        hashes_.push_back(std::move(hash), height);
 }
 
 void reservations::push_front(hash_digest&& hash, size_t height)
@@ -130,6 +180,331 @@ void reservations::populate(reservation::ptr minimal)
     ///////////////////////////////////////////////////////////////////////////
 }
 
+// Call once for each header reindexation, in place of each row populating
+// itself, so that only the rows that gain hashes contend for the table.
+void reservations::distribute()
+{
+    const auto idle = [](reservation::ptr row)
+    {
+        return !row->stopped() && row->empty();
+    };
+
+    reservation::list rows;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // The row set is initialized by the first get.
+    if (table_.empty())
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    std::copy_if(table_.begin(), table_.end(), std::back_inserter(rows), idle);
+
+    for (const auto row: rows)
+        reserve(row);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto row: rows)
+        if (!row->empty())
+            row->wake();
+}
+
+// The holder keeps its other hashes, only the blocking block is moved.
+void reservations::expedite(size_t height, const asio::duration& timeout)
+{
+    const auto now = asio::steady_clock::now();
+    reservation::ptr holder;
+    reservation::ptr target;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    if (height != frontier_ || now - frontier_since_ < timeout)
+    {
+        if (height != frontier_)
+        {
+            frontier_ = height;
+            frontier_since_ = now;
+        }
+
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    // Restart the timeout so that a move is not repeated on every check.
+    frontier_since_ = now;
+
+    for (const auto row: table_)
+    {
+        if (!row->stopped() && row->contains(height))
+        {
+            holder = row;
+            break;
+        }
+    }
+
+    const auto faster = [](reservation::ptr left, reservation::ptr right)
+    {
+        return !right || left->rate().rate() > right->rate().rate();
+    };
+
+    // Prefer the fastest idle row, otherwise the fastest active row.
+    reservation::ptr idle;
+    for (const auto row: table_)
+    {
+        if (row->stopped() || row == holder)
+            continue;
+
+        if (row->requested() == 0 && faster(row, idle))
+            idle = row;
+
+        if (faster(row, target))
+            target = row;
+    }
+
+    if (idle)
+        target = idle;
+
+    config::checkpoint check;
+    const auto held = target && target->contains(height);
+    const auto moved = holder && target && holder->release(height, check);
+
+    // A racing holder is replaced in the race by the target, unless the
+    // target is already racing for the block.
+    if (moved)
+    {
+        const auto it = races_.find(check.hash());
+
+        if (it != races_.end())
+        {
+            auto& race = it->second;
+            auto& rows = race.rows;
+            rows.erase(std::remove(rows.begin(), rows.end(), holder),
+                rows.end());
+
+            if (held)
+                --race.racers;
+            else
+                rows.push_back(target);
+        }
+
+        target->expedite(std::move(check));
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (!moved)
+        return;
+
+    LOG_DEBUG(LOG_NODE)
+        << "Expedited block [" << height << "] from slot ("
+        << holder->slot() << ") to slot (" << target->slot() << ").";
+
+    target->wake();
+}
+
+// Hashes above the window remain unreserved until validation approaches them,
+// so that blocks are still cached when read for validation.
+void reservations::slide(size_t validated_height)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_upgrade();
+
+    if (lookahead_ == 0 || validated_height <= validated_)
+    {
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    validated_ = validated_height;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Rows starved by the window may now reserve.
+    distribute();
+}
+
+// Deep queues are downloaded in height order across all slots.
+void reservations::announce(const hash_digest& hash, uint64_t channel)
+{
+    if (hashes_.size() > maximum_direct_queue)
+        return;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (announced_.size() >= maximum_announcements)
+        announced_.clear();
+
+    // The first announcement of the hash is retained.
+    announced_.emplace(hash,
+        announcement{ channel, asio::steady_clock::now() });
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// The first racing slot to receive the block imports it.
+bool reservations::claim(const hash_digest& hash, size_t slot)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    const auto it = races_.find(hash);
+
+    if (it == races_.end())
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return true;
+    }
+
+    auto& race = it->second;
+
+    if (race.claimed)
+    {
+        if (--race.racers == 0)
+            races_.erase(it);
+
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return false;
+    }
+
+    race.claimed = true;
+    --race.racers;
+
+    for (const auto row: race.rows)
+        if (row->slot() != slot && row->withdraw(hash))
+            --race.racers;
+
+    const auto latency = std::chrono::duration_cast<asio::milliseconds>(
+        asio::steady_clock::now() - race.announced);
+
+    if (race.racers == 0)
+        races_.erase(it);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    LOG_INFO(LOG_NODE)
+        << "Announced block [" << encode_hash(hash) << "] received on slot ("
+        << slot << ") in " << latency.count() << " ms.";
+
+    return true;
+}
+
+// Abandoned hashes are returned in height order, as they may be at the top.
+// External callers will invoke the lock, but a partition stop cannot.
+void reservations::abandon(const hash_digest& hash, size_t height, bool lock)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    if (lock)
+        mutex_.lock();
+
+    auto last = true;
+    const auto it = races_.find(hash);
+
+    if (it != races_.end())
+    {
+        auto& race = it->second;
+        last = !race.claimed && race.racers == 1u;
+
+        if (--race.racers == 0)
+            races_.erase(it);
+    }
+
+    if (lock)
+        mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (last)
+        hashes_.insert(hash_digest(hash), height);
+}
+
+// protected
+// The announcer receives the hash directly, racing the fastest other slot.
+bool reservations::race(const hash_digest& hash, size_t height)
+{
+    reservation::ptr announcer;
+    reservation::ptr racer;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    const auto it = announced_.find(hash);
+
+    if (it == announced_.end())
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return false;
+    }
+
+    const auto channel = it->second.channel;
+    const auto announced = it->second.time;
+    announced_.erase(it);
+
+    for (const auto row: table_)
+    {
+        if (row->stopped())
+            continue;
+
+        if (row->channel() == channel)
+            announcer = row;
+        else if (!racer || row->rate().rate() > racer->rate().rate())
+            racer = row;
+    }
+
+    if (!announcer)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return false;
+    }
+
+    reservation::list rows{ announcer };
+
+    if (racer)
+        rows.push_back(racer);
+
+    for (const auto row: rows)
+        row->expedite({ hash, height });
+
+    races_[hash] = { height, rows.size(), false, announced, rows };
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    LOG_DEBUG(LOG_NODE)
+        << "Racing announced block [" << encode_hash(hash) << "] on slot ("
+        << announcer->slot() << ")"
+        << (racer ? " and (" + std::to_string(racer->slot()) + ")." : ".");
+
+    // Waking is not deferred, as tip latency is critical.
+    for (const auto row: rows)
+        row->wake();
+
+    return true;
+}
+
 // protected
 reservation::list reservations::table() const
 {
@@ -151,11 +526,13 @@ bool reservations::reserve(reservation::ptr minimal)
     {
         initialized_ = true;
         const auto count = max_request_ * minimum_peer_count_;
-        const auto checks = std::min(count, hashes_.size());
+        auto checks = hashes_.extract(1, count, ceiling());
+        size_t row = 0;
 
         // Balance set size and block heights across the minimal row set.
-        for (size_t check = 0; check < checks; ++check)
-            table_[check % minimum_peer_count_]->insert(hashes_.pop_front());
+        // Extraction reverses the order, so insert from the lowest height.
+        for (auto check = checks.rbegin(); check != checks.rend(); ++check)
+            table_[row++ % minimum_peer_count_]->insert(std::move(*check));
     }
 
     if (!minimal->empty())
@@ -167,7 +544,8 @@ bool reservations::reserve(reservation::ptr minimal)
     }
 
     // Obtain own fraction of whatever hashes remain unreserved.
-    const auto checks = hashes_.extract(table_.size(), max_request_);
+    const auto checks = hashes_.extract(table_.size(), max_request_,
+        ceiling());
     const auto reserved = !checks.empty();
 
     // Order matters here.
@@ -344,6 +722,46 @@ size_t reservations::size() const
     return unreserved() + reserved();
 }
 
+// Idle rows do not have sufficient history for measurement.
+double reservations::rate() const
+{
+    auto rows = table();
+
+    const auto sum = [](double total, reservation::ptr row)
+    {
+        const auto current = row->rate();
+        return total + (current.idle ? 0.0 : current.rate());
+    };
+
+    return std::accumulate(rows.begin(), rows.end(), 0.0, sum);
+}
+
+// Idle rows do not have sufficient history for measurement.
+double reservations::ratio() const
+{
+    auto rows = table();
+    size_t active_rows = 0;
+
+    const auto sum = [&](double total, reservation::ptr row)
+    {
+        const auto current = row->rate();
+
+        if (current.idle)
+            return total;
+
+        ++active_rows;
+        return total + current.ratio();
+    };
+
+    const auto total = std::accumulate(rows.begin(), rows.end(), 0.0, sum);
+    return divide<double>(total, active_rows);
+}
+
+download_budget& reservations::budget()
+{
+    return budget_;
+}
+
 // protected
 size_t reservations::reserved() const
 {
@@ -363,5 +781,11 @@ size_t reservations::unreserved() const
     return hashes_.size();
 }
 
+// protected
+size_t reservations::ceiling() const
+{
+    return lookahead_ == 0 ? max_size_t : validated_ + lookahead_;
+}
+
 } // namespace node
 } // namespace libbitcoin
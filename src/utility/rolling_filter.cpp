@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/rolling_filter.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+#include <bitcoin/node/utility/bloom_filter.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+static constexpr size_t word_bits = 64;
+static constexpr size_t minimum_hash_functions = 1;
+static constexpr size_t maximum_hash_functions = 50;
+
+// The optimal bit count for the generation size and false positive rate.
+static uint32_t to_bit_count(size_t elements, double rate)
+{
+    const auto log2 = std::log(2.0);
+    const auto count = -1.0 * elements * std::log(rate) / (log2 * log2);
+    const auto words = std::ceil(std::max(count, 1.0) / word_bits);
+    return static_cast<uint32_t>(words * word_bits);
+}
+
+// The optimal hash function count for the bit count and generation size.
+static size_t to_hash_functions(uint32_t bit_count, size_t elements)
+{
+    const auto count = std::round(std::log(2.0) * bit_count / elements);
+    const auto functions = static_cast<size_t>(count);
+    return std::min(std::max(functions, minimum_hash_functions),
+        maximum_hash_functions);
+}
+
+rolling_filter::rolling_filter(size_t capacity, double false_positive_rate)
+  : generation_size_(std::max(capacity / 2u, size_t(1))),
+    bit_count_(to_bit_count(generation_size_, false_positive_rate)),
+    count_(0),
+    current_(bit_count_ / word_bits, 0),
+    previous_(bit_count_ / word_bits, 0)
+{
+    // Seeds are randomized so that collisions cannot be precomputed.
+    std::random_device device;
+    const auto functions = to_hash_functions(bit_count_, generation_size_);
+
+    for (size_t function = 0; function < functions; ++function)
+        seeds_.push_back(device());
+}
+
+void rolling_filter::insert(const hash_digest& hash)
+{
+    uint32_t positions[maximum_hash_functions];
+    indexes(positions, hash);
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    // Roll the generations when the current generation is full.
+    if (count_ == generation_size_)
+    {
+        std::swap(current_, previous_);
+        std::fill(current_.begin(), current_.end(), 0);
+        count_ = 0;
+    }
+
+    for (size_t function = 0; function < seeds_.size(); ++function)
+        current_[positions[function] / word_bits] |=
+            uint64_t(1) << (positions[function] % word_bits);
+
+    ++count_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool rolling_filter::contains(const hash_digest& hash) const
+{
+    uint32_t positions[maximum_hash_functions];
+    indexes(positions, hash);
+
+    const auto test = [&](const generation& filter)
+    {
+        for (size_t function = 0; function < seeds_.size(); ++function)
+            if ((filter[positions[function] / word_bits] &
+                (uint64_t(1) << (positions[function] % word_bits))) == 0)
+                return false;
+
+        return true;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return test(current_) || test(previous_);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void rolling_filter::clear()
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    std::fill(current_.begin(), current_.end(), 0);
+    std::fill(previous_.begin(), previous_.end(), 0);
+    count_ = 0;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// protected
+void rolling_filter::indexes(uint32_t* out, const hash_digest& hash) const
+{
+    for (size_t function = 0; function < seeds_.size(); ++function)
+        out[function] = bloom_filter::murmur3(hash, seeds_[function]) %
+            bit_count_;
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,137 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/sync_phase.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/network.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace bc::network;
+using namespace std::placeholders;
+
+sync_phase::sync_phase()
+  : stopped_(false),
+    syncing_(true)
+{
+}
+
+bool sync_phase::syncing() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return syncing_;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool sync_phase::defer(channel::ptr channel, upgrade_handler handler)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    if (stopped_ || !syncing_)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return false;
+    }
+
+    deferred_.push_back({ channel, std::move(handler) });
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    channel->subscribe_stop(std::bind(&sync_phase::handle_stop,
+        this, _1, channel->nonce()));
+
+    return true;
+}
+
+// Channels connected after the chain falls behind again are held, but those
+// already upgraded retain their relay protocols.
+void sync_phase::update(bool syncing)
+{
+    deferrals upgrades;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    if (stopped_ || syncing_ == syncing)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    syncing_ = syncing;
+
+    if (!syncing_)
+        std::swap(upgrades, deferred_);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    LOG_INFO(LOG_NODE)
+        << (syncing ? "Chain is behind, attaching sync protocols." :
+            "Chain is current, attaching relay protocols.");
+
+    if (!upgrades.empty())
+        LOG_DEBUG(LOG_NODE)
+            << "Upgrading (" << upgrades.size() << ") sync channels.";
+
+    for (const auto& upgrade: upgrades)
+        upgrade.handler(upgrade.channel);
+}
+
+void sync_phase::stop()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    stopped_ = true;
+    deferred_.clear();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// protected
+void sync_phase::handle_stop(const code&, uint64_t nonce)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    deferred_.remove_if([nonce](const deferral& held)
+    {
+        return held.channel->nonce() == nonce;
+    });
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+} // namespace node
+} // namespace libbitcoin
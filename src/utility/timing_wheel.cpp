@@ -0,0 +1,185 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/timing_wheel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace std::placeholders;
+
+timing_wheel::timing_wheel(threadpool& pool, uint32_t tick_milliseconds,
+    size_t buckets)
+  : pool_(pool),
+    tick_(asio::milliseconds(std::max(tick_milliseconds, 1u))),
+    stopped_(false),
+    running_(false),
+    cursor_(0),
+    buckets_(std::max(buckets, size_t{ 1 }))
+{
+}
+
+// A deadline is placed the number of ticks ahead that covers the delay, with
+// one round for each full turn of the wheel beyond the first.
+void timing_wheel::schedule(uint64_t key, const asio::duration& delay,
+    expiry_handler handler)
+{
+    const auto ticks = std::max<int64_t>(1, (delay + tick_ -
+        asio::duration(1)) / tick_);
+    const auto count = buckets_.size();
+    const auto span = static_cast<size_t>(ticks);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    if (stopped_)
+        return;
+
+    remove(key);
+    const auto index = (cursor_ + span) % count;
+    auto& target = buckets_[index];
+    target.push_back({ key, (span - 1u) / count, std::move(handler) });
+    positions_[key] = { index, std::prev(target.end()) };
+    start_timer();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void timing_wheel::cancel(uint64_t key)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    remove(key);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t timing_wheel::size() const
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(mutex_);
+
+    return positions_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void timing_wheel::stop()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    stopped_ = true;
+    const auto timer = timer_;
+    timer_.reset();
+    positions_.clear();
+
+    for (auto& bucket: buckets_)
+        bucket.clear();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (timer)
+        timer->stop();
+}
+
+// protected
+void timing_wheel::remove(uint64_t key)
+{
+    const auto found = positions_.find(key);
+
+    if (found == positions_.end())
+        return;
+
+    buckets_[found->second.index].erase(found->second.it);
+    positions_.erase(found);
+}
+
+// protected
+void timing_wheel::start_timer()
+{
+    if (running_ || stopped_)
+        return;
+
+    running_ = true;
+    timer_ = std::make_shared<deadline>(pool_, tick_);
+    timer_->start(std::bind(&timing_wheel::handle_timer, this, _1));
+}
+
+// protected
+void timing_wheel::handle_timer(const code& ec)
+{
+    std::vector<expiry_handler> expired;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    running_ = false;
+
+    // The timer is canceled (with error) only when the wheel stops.
+    if (stopped_ || ec)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    cursor_ = (cursor_ + 1u) % buckets_.size();
+    auto& current = buckets_[cursor_];
+
+    for (auto it = current.begin(); it != current.end();)
+    {
+        if (it->rounds != 0)
+        {
+            --it->rounds;
+            ++it;
+            continue;
+        }
+
+        expired.push_back(std::move(it->handler));
+        positions_.erase(it->key);
+        it = current.erase(it);
+    }
+
+    // The wheel idles while there are no pending deadlines.
+    if (!positions_.empty())
+        start_timer();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& handler: expired)
+        handler(error::success);
+}
+
+} // namespace node
+} // namespace libbitcoin
@@ -0,0 +1,339 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/transaction_requests.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+// Expiration is evaluated at most this often across all channels.
+static const asio::milliseconds expiration_interval(250);
+
+// Unmeasured channels rank behind channels measured faster than this.
+static const asio::seconds unmeasured_latency(2);
+
+// The weight of prior latency in the moving average (of four).
+static constexpr int64_t latency_weight = 3;
+
+// Announcements tracked per channel (as in satoshi client).
+static constexpr size_t maximum_announcements = 5000;
+
+transaction_requests::transaction_requests(uint32_t timeout_seconds,
+    uint32_t inbound_delay_seconds)
+  : timeout_(asio::seconds(timeout_seconds)),
+    inbound_delay_(asio::seconds(inbound_delay_seconds)),
+    expired_()
+{
+}
+
+// Channels.
+//-----------------------------------------------------------------------------
+
+void transaction_requests::add(uint64_t channel, bool outbound)
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    announcers_[channel] = { outbound, false, unmeasured_latency, {}, {} };
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_requests::remove(uint64_t channel)
+{
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto peer = announcers_.find(channel);
+
+    if (peer == announcers_.end())
+        return;
+
+    // Requests of the channel expire now and fall back to other announcers.
+    for (const auto& hash: peer->second.announced)
+    {
+        const auto it = requests_.find(hash);
+
+        if (it == requests_.end())
+            continue;
+
+        auto& entry = it->second;
+        auto& announcers = entry.announcers;
+        announcers.erase(std::remove(announcers.begin(), announcers.end(),
+            channel), announcers.end());
+
+        if (entry.assigned && entry.channel == channel)
+            reschedule(hash, entry, now);
+    }
+
+    announcers_.erase(peer);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Requests.
+//-----------------------------------------------------------------------------
+
+bool transaction_requests::announce(uint64_t channel, const hash_digest& hash)
+{
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto peer = announcers_.find(channel);
+
+    // Announcements from unregistered or saturated channels are not tracked.
+    if (peer == announcers_.end() ||
+        peer->second.announced.size() >= maximum_announcements)
+        return false;
+
+    const auto it = requests_.find(hash);
+
+    if (it != requests_.end())
+    {
+        if (peer->second.announced.insert(hash).second)
+            it->second.announcers.push_back(channel);
+
+        return false;
+    }
+
+    peer->second.announced.insert(hash);
+
+    // Inbound announcements wait for a possible outbound announcement.
+    if (!peer->second.outbound)
+    {
+        const auto deadline = now + inbound_delay_;
+        requests_[hash] = { false, 0, now, deadline, { channel } };
+        deadlines_.emplace(deadline, hash);
+        return false;
+    }
+
+    const auto deadline = now + timeout_;
+    requests_[hash] = { true, channel, now, deadline, { channel } };
+    deadlines_.emplace(deadline, hash);
+    return true;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_requests::complete(uint64_t channel, const hash_digest& hash)
+{
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto it = requests_.find(hash);
+
+    if (it == requests_.end())
+        return;
+
+    const auto& entry = it->second;
+    const auto peer = announcers_.find(channel);
+
+    if (entry.assigned && entry.channel == channel && peer != announcers_.end())
+    {
+        auto& latency = peer->second.latency;
+        const auto sample = now - entry.requested;
+
+        // The first measurement replaces the unmeasured penalty.
+        latency = peer->second.measured ? (latency * latency_weight +
+            sample) / (latency_weight + 1) : sample;
+
+        peer->second.measured = true;
+    }
+
+    drop(it);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void transaction_requests::not_found(uint64_t channel, const hash_digest& hash)
+{
+    const auto now = asio::steady_clock::now();
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    const auto it = requests_.find(hash);
+
+    if (it == requests_.end())
+        return;
+
+    auto& entry = it->second;
+    const auto assigned = entry.assigned && entry.channel == channel;
+    withdraw(hash, entry, channel);
+
+    if (assigned)
+        reschedule(hash, entry, now);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+hash_list transaction_requests::reassigned(uint64_t channel)
+{
+    const auto now = asio::steady_clock::now();
+    hash_list out;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    unique_lock lock(mutex_);
+
+    if (now >= expired_ + expiration_interval)
+    {
+        expire(now);
+        expired_ = now;
+    }
+
+    const auto peer = announcers_.find(channel);
+
+    if (peer != announcers_.end())
+        std::swap(out, peer->second.assigned);
+
+    return out;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+size_t transaction_requests::size() const
+{
+    ///////////////////////////////////////////////////////////////////////////
+    // Critical Section
+    shared_lock lock(mutex_);
+
+    return requests_.size();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// protected
+// Must be called from within a unique lock.
+void transaction_requests::expire(const asio::time_point& now)
+{
+    // Collect first, as reassignment schedules new deadlines.
+    hash_list expired;
+
+    for (auto it = deadlines_.begin(); it != deadlines_.end() &&
+        it->first <= now; ++it)
+        expired.push_back(it->second);
+
+    for (const auto& hash: expired)
+    {
+        const auto it = requests_.find(hash);
+
+        if (it == requests_.end())
+            continue;
+
+        auto& entry = it->second;
+
+        // A timed out announcer is not asked again for this transaction.
+        if (entry.assigned)
+            withdraw(hash, entry, entry.channel);
+
+        if (!assign(hash, entry, now))
+            drop(it);
+    }
+}
+
+// protected
+// Must be called from within a unique lock.
+bool transaction_requests::assign(const hash_digest& hash, request& entry,
+    const asio::time_point& now)
+{
+    auto best = announcers_.end();
+
+    for (const auto channel: entry.announcers)
+    {
+        const auto peer = announcers_.find(channel);
+
+        if (peer == announcers_.end())
+            continue;
+
+        // Outbound is preferred over inbound, then lower latency.
+        if (best == announcers_.end() ||
+            (peer->second.outbound && !best->second.outbound) ||
+            (peer->second.outbound == best->second.outbound &&
+                peer->second.latency < best->second.latency))
+            best = peer;
+    }
+
+    if (best == announcers_.end())
+        return false;
+
+    entry.assigned = true;
+    entry.channel = best->first;
+    entry.requested = now;
+    reschedule(hash, entry, now + timeout_);
+    best->second.assigned.push_back(hash);
+    return true;
+}
+
+// protected
+// Must be called from within a unique lock.
+void transaction_requests::reschedule(const hash_digest& hash,
+    request& entry, const asio::time_point& time)
+{
+    deadlines_.erase({ entry.deadline, hash });
+    entry.deadline = time;
+    deadlines_.emplace(time, hash);
+}
+
+// protected
+// Must be called from within a unique lock.
+void transaction_requests::withdraw(const hash_digest& hash, request& entry,
+    uint64_t channel)
+{
+    auto& announcers = entry.announcers;
+    announcers.erase(std::remove(announcers.begin(), announcers.end(),
+        channel), announcers.end());
+
+    const auto peer = announcers_.find(channel);
+
+    if (peer != announcers_.end())
+        peer->second.announced.erase(hash);
+}
+
+// protected
+// Must be called from within a unique lock.
+void transaction_requests::drop(request_map::iterator it)
+{
+    const auto& hash = it->first;
+    auto& entry = it->second;
+
+    for (const auto channel: entry.announcers)
+    {
+        const auto peer = announcers_.find(channel);
+
+        if (peer != announcers_.end())
+            peer->second.announced.erase(hash);
+    }
+
+    deadlines_.erase({ entry.deadline, hash });
+    requests_.erase(it);
+}
+
+} // namespace node
+} // namespace libbitcoin
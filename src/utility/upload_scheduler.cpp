@@ -0,0 +1,281 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/node/utility/upload_scheduler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <bitcoin/bitcoin.hpp>
+#include <bitcoin/node/define.hpp>
+
+namespace libbitcoin {
+namespace node {
+
+using namespace std::placeholders;
+
+// The number of concurrently-granted (non-priority) store reads.
+static constexpr size_t maximum_grants = 4;
+
+// The byte credit given to a channel each time it is passed over.
+static constexpr int64_t quantum = 1000000;
+
+// The number of recently-announced blocks served with priority.
+static constexpr size_t maximum_tips = 16;
+
+// The minimum delay before retrying an exhausted rate bucket.
+static const asio::milliseconds minimum_delay(10);
+
+upload_scheduler::upload_scheduler(threadpool& pool,
+    uint32_t kilobytes_per_second)
+  : pool_(pool),
+    bytes_per_second_(static_cast<int64_t>(kilobytes_per_second) * 1000),
+    stopped_(false),
+    waiting_(false),
+    tokens_(bytes_per_second_),
+    refilled_(asio::steady_clock::now())
+{
+}
+
+void upload_scheduler::enqueue(uint64_t channel, const hash_digest& hash,
+    grant_handler handler)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock_upgrade();
+
+    if (stopped_)
+    {
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        handler(error::service_stopped);
+        return;
+    }
+
+    // Tip blocks are not queued, rate limited or counted against the channel.
+    if (is_tip(hash))
+    {
+        mutex_.unlock_upgrade();
+        //---------------------------------------------------------------------
+        handler(error::success);
+        return;
+    }
+
+    mutex_.unlock_upgrade_and_lock();
+    //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+    auto& queue = pending_[channel];
+
+    // A channel enters the round only when idle (not queued or granted).
+    if (queue.empty() && granted_.find(channel) == granted_.end())
+        round_.push_back(channel);
+
+    queue.push_back({ hash, std::move(handler) });
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    dispatch();
+}
+
+void upload_scheduler::complete(uint64_t channel, const hash_digest& hash,
+    size_t bytes)
+{
+    const auto cost = static_cast<int64_t>(bytes);
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    // Priority uploads are charged to the bucket but not to the channel.
+    tokens_ -= cost;
+    const auto it = granted_.find(channel);
+
+    if (it == granted_.end() || it->second != hash)
+    {
+        mutex_.unlock();
+        //---------------------------------------------------------------------
+        return;
+    }
+
+    granted_.erase(it);
+    deficits_[channel] -= cost;
+
+    // Return the channel to the back of the round if it has more requests.
+    const auto queue = pending_.find(channel);
+    if (queue != pending_.end() && !queue->second.empty())
+        round_.push_back(channel);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    dispatch();
+}
+
+void upload_scheduler::remove(uint64_t channel)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    const auto released = granted_.erase(channel) != 0;
+    pending_.erase(channel);
+    deficits_.erase(channel);
+    round_.remove(channel);
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (released)
+        dispatch();
+}
+
+void upload_scheduler::announce(const hash_digest& hash)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(mutex_);
+
+    tips_.push_back(hash);
+
+    if (tips_.size() > maximum_tips)
+        tips_.pop_front();
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+void upload_scheduler::stop()
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    stopped_ = true;
+    const auto timer = timer_;
+    timer_.reset();
+    round_.clear();
+    pending_.clear();
+    granted_.clear();
+    deficits_.clear();
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (timer)
+        timer->stop();
+}
+
+// protected
+bool upload_scheduler::is_tip(const hash_digest& hash) const
+{
+    return std::find(tips_.begin(), tips_.end(), hash) != tips_.end();
+}
+
+// protected
+void upload_scheduler::refill()
+{
+    if (bytes_per_second_ == 0)
+        return;
+
+    const auto now = asio::steady_clock::now();
+    const auto elapsed = std::chrono::duration_cast<asio::microseconds>(
+        now - refilled_).count();
+    const auto credit = bytes_per_second_ * elapsed / 1000000;
+
+    // Allow no more than one second of accumulated burst.
+    tokens_ = std::min(tokens_ + credit, bytes_per_second_);
+    refilled_ = now;
+}
+
+// protected
+void upload_scheduler::dispatch()
+{
+    std::vector<grant_handler> grants;
+
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    refill();
+    const auto limited = bytes_per_second_ != 0;
+
+    // Deficit round robin: a channel in debt is credited and passed over.
+    // Each pass over a channel increases its deficit so this terminates.
+    while (!stopped_ && !round_.empty() && granted_.size() < maximum_grants &&
+        (!limited || tokens_ > 0))
+    {
+        const auto channel = round_.front();
+        auto& deficit = deficits_[channel];
+
+        if (deficit < 0)
+        {
+            deficit = std::min(deficit + quantum, quantum);
+            round_.splice(round_.end(), round_, round_.begin());
+            continue;
+        }
+
+        round_.pop_front();
+        auto& queue = pending_[channel];
+        BITCOIN_ASSERT(!queue.empty());
+        granted_[channel] = queue.front().hash;
+        grants.push_back(std::move(queue.front().handler));
+        queue.pop_front();
+    }
+
+    // Schedule a retry once the bucket is expected to be positive.
+    if (!stopped_ && limited && tokens_ <= 0 && !round_.empty() && !waiting_)
+    {
+        waiting_ = true;
+        const auto debt = static_cast<uint64_t>(1 - tokens_);
+        const auto delay = std::max(minimum_delay, asio::milliseconds(
+            debt * 1000 / static_cast<uint64_t>(bytes_per_second_)));
+
+        timer_ = std::make_shared<deadline>(pool_, delay);
+        timer_->start(std::bind(&upload_scheduler::handle_timer, this, _1));
+    }
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    for (const auto& handler: grants)
+        handler(error::success);
+}
+
+// protected
+void upload_scheduler::handle_timer(const code& ec)
+{
+    // Critical Section
+    ///////////////////////////////////////////////////////////////////////////
+    mutex_.lock();
+
+    waiting_ = false;
+    const auto stopped = stopped_;
+
+    mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    // The timer is canceled (with error) only when the scheduler stops.
+    if (!stopped && !ec)
+        dispatch();
+}
+
+} // namespace node
+} // namespace libbitcoin
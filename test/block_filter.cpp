@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(block_filter_tests)
+
+// BIP158 test vector (testnet genesis block).
+static const auto genesis_filter = to_chunk(base16_literal("019dfca8"));
+static const auto genesis_header = hash_literal(
+    "21584579b7eb08997773e5aeff3a7f932700042d0ed2a6129012b7d7ae81b750");
+
+// compute
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(block_filter__compute__genesis__expected)
+{
+    data_chunk filter;
+    BOOST_REQUIRE(block_filter::compute(filter, block::genesis_testnet()));
+    BOOST_REQUIRE_EQUAL(encode_base16(filter), encode_base16(genesis_filter));
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__compute__missing_prevout__false)
+{
+    auto instance = block::genesis_testnet();
+    auto transactions = instance.transactions();
+    const auto coinbase = transactions.front().hash();
+
+    // The previous output is not populated by validation.
+    const input spend{ output_point{ coinbase, 0 }, script{}, 0 };
+    transactions.push_back(transaction{ 1, 0, { spend }, {} });
+    instance.set_transactions(transactions);
+
+    data_chunk filter;
+    BOOST_REQUIRE(!block_filter::compute(filter, instance));
+}
+
+// to_header
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(block_filter__to_header__genesis__expected)
+{
+    const auto header = block_filter::to_header(genesis_filter, null_hash);
+    BOOST_REQUIRE_EQUAL(encode_hash(header), encode_hash(genesis_header));
+}
+
+// contains
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(block_filter__contains__output_script__true)
+{
+    const auto genesis = block::genesis_testnet();
+    const auto& output = genesis.transactions().front().outputs().front();
+    const auto script = output.script().to_data(false);
+    BOOST_REQUIRE(block_filter::contains(genesis_filter, genesis.hash(),
+        script));
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__contains__other_element__false)
+{
+    const auto genesis = block::genesis_testnet();
+    BOOST_REQUIRE(!block_filter::contains(genesis_filter, genesis.hash(),
+        to_chunk(base16_literal("0011223344"))));
+}
+
+BOOST_AUTO_TEST_CASE(block_filter__contains__empty_filter__false)
+{
+    const auto genesis = block::genesis_testnet();
+    BOOST_REQUIRE(!block_filter::contains({ 0x00 }, genesis.hash(),
+        to_chunk(base16_literal("0011223344"))));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
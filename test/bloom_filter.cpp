@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(bloom_filter_tests)
+
+static data_chunk to_data(const std::string& hex)
+{
+    data_chunk out;
+    BOOST_REQUIRE(decode_base16(out, hex));
+    return out;
+}
+
+// murmur3
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__empty__expected)
+{
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(data_chunk{}, 0x00000000), 0x00000000u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(data_chunk{}, 0xfba4c795), 0x6a396f08u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(data_chunk{}, 0xffffffff), 0x81f16f39u);
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__tails__expected)
+{
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("00"), 0x00000000), 0x514e28b7u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("00"), 0xfba4c795), 0xea3f0b17u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("ff"), 0x00000000), 0xfd6cf10du);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("0011"), 0x00000000), 0x16c6b7abu);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("001122"), 0x00000000), 0x8eb51c3du);
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__murmur3__blocks__expected)
+{
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("00112233"), 0x00000000), 0xb4471bf8u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("0011223344"), 0x00000000), 0xe2301fa8u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("001122334455"), 0x00000000), 0xfc2e4a15u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("00112233445566"), 0x00000000), 0xb074502cu);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("0011223344556677"), 0x00000000), 0x8034d2a0u);
+    BOOST_REQUIRE_EQUAL(bloom_filter::murmur3(to_data("001122334455667788"), 0x00000000), 0xb4698defu);
+}
+
+// is_valid
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(bloom_filter__is_valid__limits__true)
+{
+    const data_chunk data(bloom_filter::max_filter_bytes, 0x00);
+    const bloom_filter instance(data, bloom_filter::max_hash_functions, 0, 0);
+    BOOST_REQUIRE(instance.is_valid());
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__is_valid__oversized__false)
+{
+    const data_chunk data(bloom_filter::max_filter_bytes + 1, 0x00);
+    const bloom_filter instance(data, 1, 0, 0);
+    BOOST_REQUIRE(!instance.is_valid());
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__is_valid__excess_hash_functions__false)
+{
+    const data_chunk data(1, 0x00);
+    const bloom_filter instance(data, bloom_filter::max_hash_functions + 1, 0, 0);
+    BOOST_REQUIRE(!instance.is_valid());
+}
+
+// insert/contains
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__empty__false)
+{
+    const bloom_filter instance(data_chunk(3, 0x00), 5, 0, 0);
+    BOOST_REQUIRE(!instance.contains(to_data("99108ad8ed9bb6274d3980bab5a85c048f0950c8")));
+}
+
+// BIP37 reference vector (serializes to 614e9b with five hash functions).
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__inserted__expected)
+{
+    bloom_filter instance(data_chunk(3, 0x00), 5, 0, bloom_filter::update_all);
+    instance.insert(to_data("99108ad8ed9bb6274d3980bab5a85c048f0950c8"));
+    instance.insert(to_data("b5a2c786d9ef4658287ced5914b37a1b4aa32eee"));
+    instance.insert(to_data("b9300670b4c5366e95b2699e8b18bc75e5f729c5"));
+
+    BOOST_REQUIRE(instance.contains(to_data("99108ad8ed9bb6274d3980bab5a85c048f0950c8")));
+    BOOST_REQUIRE(!instance.contains(to_data("19108ad8ed9bb6274d3980bab5a85c048f0950c8")));
+    BOOST_REQUIRE(instance.contains(to_data("b5a2c786d9ef4658287ced5914b37a1b4aa32eee")));
+    BOOST_REQUIRE(instance.contains(to_data("b9300670b4c5366e95b2699e8b18bc75e5f729c5")));
+}
+
+BOOST_AUTO_TEST_CASE(bloom_filter__contains__preloaded__expected)
+{
+    const bloom_filter instance(to_data("614e9b"), 5, 0, 0);
+    BOOST_REQUIRE(instance.contains(to_data("99108ad8ed9bb6274d3980bab5a85c048f0950c8")));
+    BOOST_REQUIRE(!instance.contains(to_data("19108ad8ed9bb6274d3980bab5a85c048f0950c8")));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
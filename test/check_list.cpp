@@ -20,6 +20,7 @@
 #include <bitcoin/node.hpp>
 
 using namespace bc;
+using namespace bc::node;
 
 BOOST_AUTO_TEST_SUITE(check_list_tests)
 
@@ -28,4 +29,89 @@ BOOST_AUTO_TEST_CASE(todo)
     BOOST_REQUIRE(true);
 }
 
+// extract
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(check_list__extract__unbounded__all_reversed)
+{
+    check_list instance;
+    instance.push_back(hash_digest{ { 1 } }, 1);
+    instance.push_back(hash_digest{ { 2 } }, 2);
+    instance.push_back(hash_digest{ { 3 } }, 3);
+
+    const auto checks = instance.extract(1, 10);
+    BOOST_REQUIRE_EQUAL(checks.size(), 3u);
+    BOOST_REQUIRE_EQUAL(checks.front().height(), 3u);
+    BOOST_REQUIRE(instance.empty());
+}
+
+BOOST_AUTO_TEST_CASE(check_list__extract__maximum_height__excludes_above)
+{
+    check_list instance;
+    instance.push_back(hash_digest{ { 1 } }, 1);
+    instance.push_back(hash_digest{ { 2 } }, 2);
+    instance.push_back(hash_digest{ { 3 } }, 3);
+
+    const auto checks = instance.extract(1, 10, 2);
+    BOOST_REQUIRE_EQUAL(checks.size(), 2u);
+    BOOST_REQUIRE_EQUAL(checks.front().height(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(check_list__extract__front_above_maximum__empty)
+{
+    check_list instance;
+    instance.push_back(hash_digest{ { 5 } }, 5);
+
+    BOOST_REQUIRE(instance.extract(1, 10, 4).empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+// truncate
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(check_list__truncate__above_fork__removed)
+{
+    check_list instance;
+    instance.push_back(hash_digest{ { 1 } }, 1);
+    instance.push_back(hash_digest{ { 2 } }, 2);
+    instance.push_back(hash_digest{ { 3 } }, 3);
+
+    BOOST_REQUIRE_EQUAL(instance.truncate(1), 2u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(check_list__truncate__above_top__unchanged)
+{
+    check_list instance;
+    instance.push_back(hash_digest{ { 1 } }, 1);
+
+    BOOST_REQUIRE_EQUAL(instance.truncate(1), 0u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+// insert
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(check_list__insert__between__height_ordered)
+{
+    check_list instance;
+    instance.push_back(hash_digest{ { 1 } }, 1);
+    instance.push_back(hash_digest{ { 3 } }, 3);
+
+    BOOST_REQUIRE(instance.insert(hash_digest{ { 2 } }, 2));
+    BOOST_REQUIRE_EQUAL(instance.pop_front().height(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.pop_front().height(), 2u);
+    BOOST_REQUIRE_EQUAL(instance.pop_front().height(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(check_list__insert__existing_height__false)
+{
+    check_list instance;
+    instance.push_back(hash_digest{ { 1 } }, 1);
+
+    BOOST_REQUIRE(!instance.insert(hash_digest{ { 2 } }, 1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(download_budget_tests)
+
+// draw
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(download_budget__draw__unlimited__all_granted)
+{
+    download_budget instance(0, 100);
+    uint64_t bytes;
+    BOOST_REQUIRE_EQUAL(instance.draw(42, bytes), 42u);
+    BOOST_REQUIRE_EQUAL(bytes, 4200u);
+    BOOST_REQUIRE_EQUAL(instance.outstanding(), 4200u);
+}
+
+BOOST_AUTO_TEST_CASE(download_budget__draw__exceeds_budget__limited)
+{
+    download_budget instance(1000, 100);
+    uint64_t bytes;
+    BOOST_REQUIRE_EQUAL(instance.draw(42, bytes), 10u);
+    BOOST_REQUIRE_EQUAL(bytes, 1000u);
+    BOOST_REQUIRE_EQUAL(instance.draw(1, bytes), 0u);
+    BOOST_REQUIRE_EQUAL(bytes, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(download_budget__draw__block_exceeds_empty_budget__one_granted)
+{
+    download_budget instance(10, 100);
+    uint64_t bytes;
+    BOOST_REQUIRE_EQUAL(instance.draw(42, bytes), 1u);
+    BOOST_REQUIRE_EQUAL(bytes, 100u);
+    BOOST_REQUIRE_EQUAL(instance.draw(42, bytes), 0u);
+}
+
+// refund
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(download_budget__refund__drawn__credit_restored)
+{
+    download_budget instance(1000, 100);
+    uint64_t bytes;
+    instance.draw(42, bytes);
+    instance.refund(300);
+    BOOST_REQUIRE_EQUAL(instance.outstanding(), 700u);
+    BOOST_REQUIRE_EQUAL(instance.draw(42, bytes), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(download_budget__refund__excess__zero_outstanding)
+{
+    download_budget instance(1000, 100);
+    instance.refund(300);
+    BOOST_REQUIRE_EQUAL(instance.outstanding(), 0u);
+}
+
+// record
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(download_budget__record__smaller_blocks__estimate_decreases)
+{
+    download_budget instance(1000, 1600);
+    instance.record(0);
+    BOOST_REQUIRE_EQUAL(instance.estimate(), 1500u);
+}
+
+// utilization
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(download_budget__utilization__half_drawn__half)
+{
+    download_budget instance(1000, 100);
+    uint64_t bytes;
+    instance.draw(5, bytes);
+    BOOST_REQUIRE_EQUAL(instance.utilization(), 0.5);
+}
+
+BOOST_AUTO_TEST_CASE(download_budget__utilization__unlimited__zero)
+{
+    download_budget instance(0, 100);
+    uint64_t bytes;
+    instance.draw(5, bytes);
+    BOOST_REQUIRE_EQUAL(instance.utilization(), 0.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
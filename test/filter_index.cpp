@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::chain;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(filter_index_tests)
+
+#define TEST_FILE "filter_index.tests"
+
+// BIP158 test vector (testnet genesis block).
+static const auto genesis_header = hash_literal(
+    "21584579b7eb08997773e5aeff3a7f932700042d0ed2a6129012b7d7ae81b750");
+
+class filter_index_setup_fixture
+{
+public:
+    filter_index_setup_fixture()
+    {
+        boost::filesystem::remove(TEST_FILE);
+    }
+
+    ~filter_index_setup_fixture()
+    {
+        boost::filesystem::remove(TEST_FILE);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(filter_index_fixture, filter_index_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(filter_index__start__no_file__empty)
+{
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE(boost::filesystem::exists(TEST_FILE));
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__catch_up__genesis__expected)
+{
+    const auto genesis = block::genesis_testnet();
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(instance.catch_up(genesis, 0, 0));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    size_t height;
+    BOOST_REQUIRE(instance.get_height(height, genesis.hash()));
+    BOOST_REQUIRE_EQUAL(height, 0u);
+
+    hash_digest block_hash;
+    hash_digest filter_hash;
+    hash_digest filter_header;
+    BOOST_REQUIRE(instance.get_hashes(block_hash, filter_hash, filter_header, 0));
+    BOOST_REQUIRE_EQUAL(encode_hash(block_hash), encode_hash(genesis.hash()));
+    BOOST_REQUIRE_EQUAL(encode_hash(filter_header), encode_hash(genesis_header));
+
+    data_chunk filter;
+    BOOST_REQUIRE(instance.get_filter(filter, 0));
+    BOOST_REQUIRE_EQUAL(encode_base16(filter), "019dfca8");
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__start__existing_file__reloaded)
+{
+    const auto genesis = block::genesis_testnet();
+    {
+        filter_index instance(TEST_FILE);
+        BOOST_REQUIRE(instance.start());
+        BOOST_REQUIRE(instance.catch_up(genesis, 0, 0));
+    }
+
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.catch_up(genesis, 0, 0));
+
+    data_chunk filter;
+    BOOST_REQUIRE(instance.get_filter(filter, 0));
+    BOOST_REQUIRE_EQUAL(encode_base16(filter), "019dfca8");
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__start__existing_file__unavailable)
+{
+    const auto genesis = block::genesis_testnet();
+    {
+        filter_index instance(TEST_FILE);
+        BOOST_REQUIRE(instance.start());
+        BOOST_REQUIRE(instance.catch_up(genesis, 0, 0));
+    }
+
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(!instance.available());
+
+    hash_digest block_hash;
+    BOOST_REQUIRE(instance.get_block_hash(block_hash, 0));
+    BOOST_REQUIRE_EQUAL(encode_hash(block_hash), encode_hash(genesis.hash()));
+
+    data_chunk filter;
+    BOOST_REQUIRE(!instance.get_filter(filter, 0));
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__catch_up__below_top__unavailable)
+{
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(instance.catch_up(block::genesis_testnet(), 0, 1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(!instance.available());
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__catch_up__gap__false)
+{
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(!instance.catch_up(block::genesis_testnet(), 1, 1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__catch_up__not_child__false)
+{
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(instance.catch_up(block::genesis_testnet(), 0, 1));
+    BOOST_REQUIRE(!instance.catch_up(block::genesis_mainnet(), 1, 1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(!instance.available());
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__catch_up__stale_block__replaced)
+{
+    const auto genesis = block::genesis_mainnet();
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(instance.catch_up(block::genesis_testnet(), 0, 0));
+    BOOST_REQUIRE(instance.catch_up(genesis, 0, 0));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.available());
+
+    size_t height;
+    BOOST_REQUIRE(instance.get_height(height, genesis.hash()));
+    BOOST_REQUIRE_EQUAL(height, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__reorganize__fork_not_indexed__false)
+{
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(!instance.reorganize(0, {}));
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__reorganize__fork_not_indexed__unavailable)
+{
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(instance.catch_up(block::genesis_testnet(), 0, 0));
+    BOOST_REQUIRE(instance.available());
+    BOOST_REQUIRE(!instance.reorganize(1, {}));
+    BOOST_REQUIRE(!instance.available());
+
+    data_chunk filter;
+    BOOST_REQUIRE(!instance.get_filter(filter, 0));
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__reorganize__fork_indexed__restored)
+{
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(instance.catch_up(block::genesis_testnet(), 0, 0));
+    BOOST_REQUIRE(!instance.reorganize(1, {}));
+    BOOST_REQUIRE(instance.reorganize(0, {}));
+    BOOST_REQUIRE(instance.available());
+
+    data_chunk filter;
+    BOOST_REQUIRE(instance.get_filter(filter, 0));
+    BOOST_REQUIRE_EQUAL(encode_base16(filter), "019dfca8");
+}
+
+BOOST_AUTO_TEST_CASE(filter_index__get_filter__above_top__false)
+{
+    filter_index instance(TEST_FILE);
+    BOOST_REQUIRE(instance.start());
+    BOOST_REQUIRE(instance.catch_up(block::genesis_testnet(), 0, 0));
+
+    data_chunk filter;
+    BOOST_REQUIRE(!instance.get_filter(filter, 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
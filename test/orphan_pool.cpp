@@ -0,0 +1,131 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(orphan_pool_tests)
+
+static const hash_digest parent1{ { 1 } };
+static const hash_digest parent2{ { 2 } };
+
+// Previous outputs are not populated, so all parents are missing.
+static transaction_const_ptr make_orphan(const hash_list& parents,
+    uint32_t index=0)
+{
+    chain::input::list inputs;
+    for (const auto& parent: parents)
+        inputs.emplace_back(chain::output_point{ parent, index },
+            chain::script{}, 0);
+
+    return std::make_shared<const message::transaction>(1, 0,
+        std::move(inputs), chain::output::list{});
+}
+
+// store
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(orphan_pool__store__orphan__true)
+{
+    orphan_pool instance(1000000, 60);
+    const auto orphan = make_orphan({ parent1 });
+    BOOST_REQUIRE(instance.store(orphan));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(), orphan->serialized_size(true));
+}
+
+BOOST_AUTO_TEST_CASE(orphan_pool__store__duplicate__false)
+{
+    orphan_pool instance(1000000, 60);
+    const auto orphan = make_orphan({ parent1 });
+    BOOST_REQUIRE(instance.store(orphan));
+    BOOST_REQUIRE(!instance.store(orphan));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(orphan_pool__store__over_size_limit__evicts_oldest)
+{
+    const auto orphan1 = make_orphan({ parent1 });
+    const auto orphan2 = make_orphan({ parent2 });
+    orphan_pool instance(orphan1->serialized_size(true), 60);
+    BOOST_REQUIRE(instance.store(orphan1));
+    BOOST_REQUIRE(instance.store(orphan2));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(instance.resolve(parent1).empty());
+    BOOST_REQUIRE_EQUAL(instance.resolve(parent2).size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(orphan_pool__store__expired__evicted)
+{
+    orphan_pool instance(1000000, 0);
+    BOOST_REQUIRE(!instance.store(make_orphan({ parent1 })));
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+// resolve
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(orphan_pool__resolve__last_parent__arrival_order)
+{
+    orphan_pool instance(1000000, 60);
+    const auto orphan1 = make_orphan({ parent1 }, 0);
+    const auto orphan2 = make_orphan({ parent1 }, 1);
+    BOOST_REQUIRE(instance.store(orphan1));
+    BOOST_REQUIRE(instance.store(orphan2));
+
+    const auto resolved = instance.resolve(parent1);
+    BOOST_REQUIRE_EQUAL(resolved.size(), 2u);
+    BOOST_REQUIRE(resolved[0] == orphan1);
+    BOOST_REQUIRE(resolved[1] == orphan2);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.bytes(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(orphan_pool__resolve__other_parent_missing__retained)
+{
+    orphan_pool instance(1000000, 60);
+    const auto orphan = make_orphan({ parent1, parent2 });
+    BOOST_REQUIRE(instance.store(orphan));
+    BOOST_REQUIRE(instance.resolve(parent1).empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    const auto resolved = instance.resolve(parent2);
+    BOOST_REQUIRE_EQUAL(resolved.size(), 1u);
+    BOOST_REQUIRE(resolved.front() == orphan);
+}
+
+// remove
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(orphan_pool__remove__stored__removed)
+{
+    orphan_pool instance(1000000, 60);
+    const auto orphan = make_orphan({ parent1 });
+    BOOST_REQUIRE(instance.store(orphan));
+    instance.remove(orphan->hash());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE(instance.resolve(parent1).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,166 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(outbound_scaler_tests)
+
+// ceiling
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__ceiling__below_steady__steady)
+{
+    outbound_scaler instance(8, 4, 0);
+    BOOST_REQUIRE_EQUAL(instance.ceiling(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__ceiling__above_steady__ceiling)
+{
+    outbound_scaler instance(8, 24, 0);
+    BOOST_REQUIRE_EQUAL(instance.ceiling(), 24u);
+}
+
+// admit
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__admit__below_target__admitted)
+{
+    outbound_scaler instance(8, 24, 0);
+    code result = error::unknown;
+    instance.admit([&](const code& ec)
+    {
+        result = ec;
+    });
+
+    BOOST_REQUIRE_EQUAL(result, error::success);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__admit__zero_target__parked)
+{
+    outbound_scaler instance(0, 24, 0);
+    auto invoked = false;
+    instance.admit([&](const code&)
+    {
+        invoked = true;
+    });
+
+    BOOST_REQUIRE(!invoked);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__admit__stopped__service_stopped)
+{
+    outbound_scaler instance(8, 24, 0);
+    instance.stop();
+    code result;
+    instance.admit([&](const code& ec)
+    {
+        result = ec;
+    });
+
+    BOOST_REQUIRE_EQUAL(result, error::service_stopped);
+}
+
+// stop
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__stop__parked__service_stopped)
+{
+    outbound_scaler instance(0, 24, 0);
+    code result;
+    instance.admit([&](const code& ec)
+    {
+        result = ec;
+    });
+
+    instance.stop();
+    BOOST_REQUIRE_EQUAL(result, error::service_stopped);
+}
+
+// update
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__update__syncing_rising_rate__target_grows)
+{
+    outbound_scaler instance(8, 24, 0);
+    instance.update(1.0, 0.1, true);
+    BOOST_REQUIRE_EQUAL(instance.target(), 10u);
+    instance.update(2.0, 0.1, true);
+    BOOST_REQUIRE_EQUAL(instance.target(), 12u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__update__plateau__target_held)
+{
+    outbound_scaler instance(8, 24, 0);
+    instance.update(1.0, 0.1, true);
+    instance.update(1.05, 0.1, true);
+    BOOST_REQUIRE_EQUAL(instance.target(), 10u);
+    instance.update(2.0, 0.1, true);
+    BOOST_REQUIRE_EQUAL(instance.target(), 10u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__update__store_bottleneck__target_held)
+{
+    outbound_scaler instance(8, 24, 0);
+    instance.update(1.0, 0.9, true);
+    BOOST_REQUIRE_EQUAL(instance.target(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__update__ceiling__target_limited)
+{
+    outbound_scaler instance(8, 9, 0);
+    instance.update(1.0, 0.1, true);
+    BOOST_REQUIRE_EQUAL(instance.target(), 9u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__update__not_syncing__steady_target)
+{
+    outbound_scaler instance(8, 24, 0);
+    instance.update(1.0, 0.1, true);
+    instance.update(2.0, 0.1, false);
+    BOOST_REQUIRE_EQUAL(instance.target(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__update__within_interval__unchanged)
+{
+    outbound_scaler instance(8, 24, 60);
+    instance.update(1.0, 0.1, true);
+    BOOST_REQUIRE_EQUAL(instance.target(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(outbound_scaler__update__raised_target__parked_admitted)
+{
+    outbound_scaler instance(0, 24, 0);
+    size_t admitted = 0;
+    const auto handler = [&](const code& ec)
+    {
+        admitted += ec ? 0 : 1;
+    };
+
+    for (size_t attempt = 0; attempt < 3; ++attempt)
+        instance.admit(handler);
+
+    BOOST_REQUIRE_EQUAL(admitted, 0u);
+    instance.update(1.0, 0.1, true);
+    BOOST_REQUIRE_EQUAL(admitted, 2u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
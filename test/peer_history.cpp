@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(peer_history_tests)
+
+#define TEST_FILE "peer_history.tests"
+
+static const config::authority peer1("1.2.3.4:8333");
+static const config::authority peer2("5.6.7.8:8333");
+
+class peer_history_setup_fixture
+{
+public:
+    peer_history_setup_fixture()
+    {
+        boost::filesystem::remove(TEST_FILE);
+    }
+
+    ~peer_history_setup_fixture()
+    {
+        boost::filesystem::remove(TEST_FILE);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(peer_history_fixture, peer_history_setup_fixture)
+
+BOOST_AUTO_TEST_CASE(peer_history__load__no_file__empty)
+{
+    peer_history instance(TEST_FILE, 10);
+    BOOST_REQUIRE(instance.load());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(peer_history__record__repeated__smoothed)
+{
+    peer_history instance(TEST_FILE, 10);
+    instance.record(peer1, 100.0, 200, false, error::success);
+    instance.record(peer1, 200.0, 0, true, error::channel_timeout);
+
+    peer_history::entry value;
+    BOOST_REQUIRE(instance.find(value, peer1));
+    BOOST_REQUIRE_EQUAL(value.rate, 125.0);
+    BOOST_REQUIRE_EQUAL(value.latency, 200u);
+    BOOST_REQUIRE_EQUAL(value.stalls, 1u);
+    BOOST_REQUIRE_EQUAL(value.reason, static_cast<int32_t>(error::channel_timeout));
+}
+
+BOOST_AUTO_TEST_CASE(peer_history__record__full__evicted)
+{
+    peer_history instance(TEST_FILE, 1);
+    instance.record(peer1, 100.0, 0, false, error::success);
+    instance.record(peer2, 50.0, 0, false, error::success);
+
+    peer_history::entry value;
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(!instance.find(value, peer1));
+    BOOST_REQUIRE(instance.find(value, peer2));
+}
+
+BOOST_AUTO_TEST_CASE(peer_history__score__stalled__discounted)
+{
+    peer_history instance(TEST_FILE, 10);
+    instance.record(peer1, 100.0, 0, false, error::success);
+    instance.record(peer2, 100.0, 0, true, error::success);
+    BOOST_REQUIRE_GT(instance.score(peer1), instance.score(peer2));
+}
+
+BOOST_AUTO_TEST_CASE(peer_history__score__unknown__zero)
+{
+    const peer_history instance(TEST_FILE, 10);
+    BOOST_REQUIRE_EQUAL(instance.score(peer1), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(peer_history__save__load__round_trip)
+{
+    peer_history instance(TEST_FILE, 10);
+    instance.record(peer1, 100.0, 200, true, error::channel_timeout);
+    BOOST_REQUIRE(instance.save());
+
+    peer_history copy(TEST_FILE, 10);
+    BOOST_REQUIRE(copy.load());
+
+    peer_history::entry value;
+    BOOST_REQUIRE(copy.find(value, peer1));
+    BOOST_REQUIRE_EQUAL(value.rate, 100.0);
+    BOOST_REQUIRE_EQUAL(value.latency, 200u);
+    BOOST_REQUIRE_EQUAL(value.stalls, 1u);
+    BOOST_REQUIRE_EQUAL(value.reason, static_cast<int32_t>(error::channel_timeout));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(pool_index_tests)
+
+static const hash_digest hash1{ { 1 } };
+static const hash_digest hash2{ { 2 } };
+static const hash_digest hash3{ { 3 } };
+
+// insert
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(pool_index__insert__duplicate__updated)
+{
+    pool_index instance(10, 1);
+    instance.insert(hash1, 1000);
+    instance.insert(hash1, 5000);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    hash_list out;
+    instance.page(out, pool_index::first, 2000, 10);
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(pool_index__insert__full__lowest_rate_evicted)
+{
+    pool_index instance(2, 1);
+    instance.insert(hash1, 3000);
+    instance.insert(hash2, 1000);
+    instance.insert(hash3, 2000);
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+
+    hash_list out;
+    instance.page(out, pool_index::first, 0, 10);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE(out[0] == hash1);
+    BOOST_REQUIRE(out[1] == hash3);
+}
+
+// remove
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(pool_index__remove__indexed__removed)
+{
+    pool_index instance(10, 1);
+    instance.insert(hash1, 1000);
+    instance.remove(hash1);
+    instance.remove(hash2);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+// synchronize
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(pool_index__synchronize__unindexed__returned_not_added)
+{
+    pool_index instance(10, 1);
+    instance.insert(hash1, 1000);
+    const auto unindexed = instance.synchronize({ hash1, hash2 });
+    BOOST_REQUIRE_EQUAL(unindexed.size(), 1u);
+    BOOST_REQUIRE(unindexed[0] == hash2);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(pool_index__synchronize__partial_pages__rates_retained)
+{
+    pool_index instance(10, 1);
+    instance.insert(hash1, 1000);
+    instance.insert(hash2, 2000);
+    const auto sequence = instance.sequence();
+
+    // Each page holds part of the pool.
+    BOOST_REQUIRE(instance.synchronize({ hash1 }).empty());
+    BOOST_REQUIRE(instance.synchronize({ hash2 }).empty());
+    BOOST_REQUIRE_EQUAL(instance.sweep(sequence), 0u);
+
+    hash_list out;
+    instance.page(out, pool_index::first, 1000, 10);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE(out[0] == hash2);
+    BOOST_REQUIRE(out[1] == hash1);
+}
+
+// sweep
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(pool_index__sweep__not_pooled__removed)
+{
+    pool_index instance(10, 1);
+    instance.insert(hash1, 1000);
+    instance.insert(hash2, 2000);
+    const auto sequence = instance.sequence();
+    instance.synchronize({ hash2 });
+    BOOST_REQUIRE_EQUAL(instance.sweep(sequence), 1u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    hash_list out;
+    instance.page(out, pool_index::first, 0, 10);
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE(out[0] == hash2);
+}
+
+BOOST_AUTO_TEST_CASE(pool_index__sweep__inserted_after_sequence__retained)
+{
+    pool_index instance(10, 1);
+    instance.insert(hash1, 1000);
+    const auto sequence = instance.sequence();
+    instance.insert(hash2, 2000);
+    instance.synchronize({ hash3 });
+    BOOST_REQUIRE_EQUAL(instance.sweep(sequence), 1u);
+
+    hash_list out;
+    instance.page(out, pool_index::first, 0, 10);
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE(out[0] == hash2);
+}
+
+// fee_rate
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(pool_index__fee_rate__fees_over_size__per_kilobyte)
+{
+    BOOST_REQUIRE_EQUAL(pool_index::fee_rate(500, 250), 2000u);
+    BOOST_REQUIRE_EQUAL(pool_index::fee_rate(500, 0), 500000u);
+}
+
+// page
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(pool_index__page__minimum_rate__excludes_lower)
+{
+    pool_index instance(10, 1);
+    instance.insert(hash1, 1000);
+    instance.insert(hash2, 3000);
+    instance.insert(hash3, 2000);
+
+    hash_list out;
+    instance.page(out, pool_index::first, 2000, 10);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+    BOOST_REQUIRE(out[0] == hash2);
+    BOOST_REQUIRE(out[1] == hash3);
+}
+
+BOOST_AUTO_TEST_CASE(pool_index__page__cursor__resumes_after)
+{
+    pool_index instance(10, 1);
+    instance.insert(hash1, 1000);
+    instance.insert(hash2, 3000);
+    instance.insert(hash3, 2000);
+
+    hash_list out;
+    const auto cursor = instance.page(out, pool_index::first, 0, 2);
+    BOOST_REQUIRE_EQUAL(out.size(), 2u);
+
+    out.clear();
+    instance.page(out, cursor, 0, 2);
+    BOOST_REQUIRE_EQUAL(out.size(), 1u);
+    BOOST_REQUIRE(out[0] == hash1);
+}
+
+// open_stream
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(pool_index__open_stream__maximum__false_until_closed)
+{
+    pool_index instance(10, 1);
+    BOOST_REQUIRE(instance.open_stream());
+    BOOST_REQUIRE(!instance.open_stream());
+    instance.close_stream();
+    BOOST_REQUIRE(instance.open_stream());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(relay_buckets_tests)
+
+static const transaction_const_ptr tx =
+    std::make_shared<const message::transaction>();
+
+// to_bucket
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(relay_buckets__to_bucket__zero__zero)
+{
+    BOOST_REQUIRE_EQUAL(relay_buckets::to_bucket(0), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(relay_buckets__to_bucket__increasing_rate__non_decreasing)
+{
+    size_t previous = 0;
+
+    for (uint64_t rate = 0; rate < 100000; rate += 7)
+    {
+        const auto bucket = relay_buckets::to_bucket(rate);
+        BOOST_REQUIRE_GE(bucket, previous);
+        previous = bucket;
+    }
+}
+
+// relay
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(relay_buckets__relay__rate_at_filter__delivered)
+{
+    relay_buckets instance;
+    size_t delivered = 0;
+    instance.subscribe(1, 1000, [&](transaction_const_ptr, uint64_t)
+    {
+        ++delivered;
+    });
+
+    instance.relay(tx, 1000);
+    BOOST_REQUIRE_EQUAL(delivered, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(relay_buckets__relay__rate__delivered_with_transaction)
+{
+    relay_buckets instance;
+    uint64_t delivered = 0;
+    instance.subscribe(1, 1000, [&](transaction_const_ptr, uint64_t rate)
+    {
+        delivered = rate;
+    });
+
+    instance.relay(tx, 4200);
+    BOOST_REQUIRE_EQUAL(delivered, 4200u);
+}
+
+BOOST_AUTO_TEST_CASE(relay_buckets__relay__rate_below_filter__not_delivered)
+{
+    relay_buckets instance;
+    size_t delivered = 0;
+    instance.subscribe(1, 1000, [&](transaction_const_ptr, uint64_t)
+    {
+        ++delivered;
+    });
+
+    instance.relay(tx, 999);
+    instance.relay(tx, 0);
+    BOOST_REQUIRE_EQUAL(delivered, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(relay_buckets__relay__mixed_filters__eligible_only)
+{
+    relay_buckets instance;
+    size_t low = 0;
+    size_t high = 0;
+    instance.subscribe(1, 0, [&](transaction_const_ptr, uint64_t)
+    {
+        ++low;
+    });
+
+    instance.subscribe(2, 50000, [&](transaction_const_ptr, uint64_t)
+    {
+        ++high;
+    });
+
+    instance.relay(tx, 1000);
+    instance.relay(tx, 60000);
+    BOOST_REQUIRE_EQUAL(low, 2u);
+    BOOST_REQUIRE_EQUAL(high, 1u);
+}
+
+// subscribe
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(relay_buckets__subscribe__raised_filter__moved)
+{
+    relay_buckets instance;
+    size_t delivered = 0;
+    const auto handler = [&](transaction_const_ptr, uint64_t)
+    {
+        ++delivered;
+    };
+
+    instance.subscribe(1, 0, handler);
+    instance.subscribe(1, 5000, handler);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    instance.relay(tx, 1000);
+    BOOST_REQUIRE_EQUAL(delivered, 0u);
+}
+
+// update
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(relay_buckets__update__subscribed__moved)
+{
+    relay_buckets instance;
+    size_t delivered = 0;
+    instance.subscribe(1, 0, [&](transaction_const_ptr, uint64_t)
+    {
+        ++delivered;
+    });
+
+    BOOST_REQUIRE(instance.update(1, 5000));
+    instance.relay(tx, 1000);
+    instance.relay(tx, 5000);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE_EQUAL(delivered, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(relay_buckets__update__unsubscribed__false)
+{
+    relay_buckets instance;
+    size_t delivered = 0;
+    instance.subscribe(1, 0, [&](transaction_const_ptr, uint64_t)
+    {
+        ++delivered;
+    });
+
+    instance.unsubscribe(1);
+    BOOST_REQUIRE(!instance.update(1, 0));
+    instance.relay(tx, 1000);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(delivered, 0u);
+}
+
+// unsubscribe
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(relay_buckets__unsubscribe__subscribed__not_delivered)
+{
+    relay_buckets instance;
+    size_t delivered = 0;
+    instance.subscribe(1, 0, [&](transaction_const_ptr, uint64_t)
+    {
+        ++delivered;
+    });
+
+    instance.unsubscribe(1);
+    instance.relay(tx, 1000);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE_EQUAL(delivered, 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
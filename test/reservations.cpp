@@ -676,3 +676,323 @@
 ////}
 ////
 ////BOOST_AUTO_TEST_SUITE_END()
+
+#include <cstddef>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(reservations_tests)
+
+// Height 1 and 3 are reserved to the first row, 2 and 4 to the second.
+static void push(reservations& instance)
+{
+    instance.push_front(hash_digest{ { 4 } }, 4);
+    instance.push_front(hash_digest{ { 3 } }, 3);
+    instance.push_front(hash_digest{ { 2 } }, 2);
+    instance.push_front(hash_digest{ { 1 } }, 1);
+}
+
+// distribute
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__distribute__no_rows__unreserved)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    push(instance);
+    instance.distribute();
+    BOOST_REQUIRE(instance.get()->empty());
+}
+
+BOOST_AUTO_TEST_CASE(reservations__distribute__idle_rows__reserved_and_woken)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    push(instance);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+
+    size_t woken = 0;
+    const auto waker = [&](const code&) { ++woken; };
+    row0->set_waker(42, waker);
+    row1->set_waker(43, waker);
+
+    instance.distribute();
+    BOOST_REQUIRE_EQUAL(woken, 2u);
+    BOOST_REQUIRE(row0->contains(1));
+    BOOST_REQUIRE(row0->contains(3));
+    BOOST_REQUIRE(row1->contains(2));
+    BOOST_REQUIRE(row1->contains(4));
+}
+
+// expedite
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__expedite__frontier_advanced__not_moved)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    push(instance);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    instance.distribute();
+
+    instance.expedite(1, asio::duration::zero());
+    BOOST_REQUIRE(row0->contains(1));
+    BOOST_REQUIRE(!row1->contains(1));
+}
+
+BOOST_AUTO_TEST_CASE(reservations__expedite__frontier_stalled__moved)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    push(instance);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    instance.distribute();
+
+    instance.expedite(1, asio::duration::zero());
+    instance.expedite(1, asio::duration::zero());
+    BOOST_REQUIRE(!row0->contains(1));
+    BOOST_REQUIRE(row1->contains(1));
+    BOOST_REQUIRE(row0->contains(3));
+}
+
+BOOST_AUTO_TEST_CASE(reservations__expedite__expedited_stalled__moved_again)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    push(instance);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    instance.distribute();
+
+    instance.expedite(1, asio::duration::zero());
+    instance.expedite(1, asio::duration::zero());
+    BOOST_REQUIRE(row1->contains(1));
+
+    // The expedited block is requested but does not arrive.
+    BOOST_REQUIRE(!row1->request().inventories().empty());
+    instance.expedite(1, asio::duration::zero());
+    BOOST_REQUIRE(row0->contains(1));
+    BOOST_REQUIRE(!row1->contains(1));
+
+    // Its late arrival at the previous row is ignored.
+    BOOST_REQUIRE(row1->find_released_and_erase(hash_digest{ { 1 } }));
+}
+
+BOOST_AUTO_TEST_CASE(reservations__expedite__long_timeout__not_moved)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    push(instance);
+    const auto row0 = instance.get();
+    instance.get();
+    instance.distribute();
+
+    instance.expedite(1, asio::duration::zero());
+    instance.expedite(1, asio::seconds(60));
+    BOOST_REQUIRE(row0->contains(1));
+}
+
+// announce
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__announce__unannounced__queued)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    row0->set_waker(42, [](const code&) {});
+    row1->set_waker(43, [](const code&) {});
+
+    chain::header header;
+    instance.push_back(header, 5);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE(!row0->contains(5));
+    BOOST_REQUIRE(!row1->contains(5));
+}
+
+BOOST_AUTO_TEST_CASE(reservations__announce__announced__raced)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    row0->set_waker(42, [](const code&) {});
+    row1->set_waker(43, [](const code&) {});
+
+    chain::header header;
+    instance.announce(header.hash(), 42);
+    instance.push_back(header, 5);
+    BOOST_REQUIRE(row0->contains(5));
+    BOOST_REQUIRE(row1->contains(5));
+}
+
+BOOST_AUTO_TEST_CASE(reservations__announce__requested__counted)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    row0->set_waker(42, [](const code&) {});
+    row1->set_waker(43, [](const code&) {});
+
+    chain::header header;
+    instance.announce(header.hash(), 42);
+    instance.push_back(header, 5);
+    BOOST_REQUIRE_EQUAL(row0->requested(), 0u);
+
+    // An unanswered expedited request is detectable as a stall.
+    BOOST_REQUIRE_EQUAL(row0->request().inventories().size(), 1u);
+    BOOST_REQUIRE_EQUAL(row0->requested(), 1u);
+    BOOST_REQUIRE_EQUAL(row1->requested(), 0u);
+}
+
+// claim
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__claim__first_arrival__other_withdrawn)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    row0->set_waker(42, [](const code&) {});
+    row1->set_waker(43, [](const code&) {});
+
+    chain::header header;
+    const auto hash = header.hash();
+    instance.announce(hash, 42);
+    instance.push_back(header, 5);
+
+    size_t height;
+    BOOST_REQUIRE(row0->find_height_and_erase(hash, height));
+    BOOST_REQUIRE_EQUAL(height, 5u);
+    BOOST_REQUIRE(!row1->contains(5));
+
+    // Its late arrival at the other racer is ignored.
+    BOOST_REQUIRE(row1->find_released_and_erase(hash));
+}
+
+BOOST_AUTO_TEST_CASE(reservations__claim__racer_expedited__target_races)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    const auto row2 = instance.get();
+    row0->set_waker(42, [](const code&) {});
+    row1->set_waker(43, [](const code&) {});
+    row2->set_waker(44, [](const code&) {});
+
+    chain::header header;
+    const auto hash = header.hash();
+    instance.announce(hash, 42);
+    instance.push_back(header, 5);
+    BOOST_REQUIRE(!row1->request().inventories().empty());
+
+    // The stalled announcer is replaced in the race by the idle row.
+    instance.expedite(5, asio::duration::zero());
+    instance.expedite(5, asio::duration::zero());
+    BOOST_REQUIRE(!row0->contains(5));
+    BOOST_REQUIRE(row2->contains(5));
+
+    size_t height;
+    BOOST_REQUIRE(row1->find_height_and_erase(hash, height));
+    BOOST_REQUIRE(!row2->contains(5));
+}
+
+// abandon
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__abandon__last_racer__requeued)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    row0->set_waker(42, [](const code&) {});
+    row1->set_waker(43, [](const code&) {});
+
+    chain::header header;
+    instance.announce(header.hash(), 42);
+    instance.push_back(header, 5);
+
+    // Another slot remains in the race.
+    row0->stop(row0->channel());
+    BOOST_REQUIRE(row1->contains(5));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    row1->stop(row1->channel());
+    BOOST_REQUIRE(!row1->contains(5));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+// partition
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(reservations__partition__expedited_only_row__not_partitioned)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    row0->set_waker(42, [](const code&) {});
+    row1->set_waker(43, [](const code&) {});
+
+    chain::header header;
+    instance.announce(header.hash(), 42);
+    instance.push_back(header, 5);
+    BOOST_REQUIRE(!row0->empty());
+    BOOST_REQUIRE_EQUAL(row0->size(), 1u);
+
+    // The racing row does not populate itself from the other racer.
+    BOOST_REQUIRE_EQUAL(row0->request().inventories().size(), 1u);
+    BOOST_REQUIRE(!row1->stopped());
+}
+
+BOOST_AUTO_TEST_CASE(reservations__partition__maximal_row__stopped_and_woken)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    push(instance);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    instance.distribute();
+
+    size_t woken0 = 0;
+    size_t woken1 = 0;
+    row0->set_waker(42, [&](const code&) { ++woken0; });
+    row1->set_waker(43, [&](const code&) { ++woken1; });
+    BOOST_REQUIRE(!row0->request().inventories().empty());
+    BOOST_REQUIRE(!row1->request().inventories().empty());
+
+    // The empty row takes half of the maximal row.
+    const auto row2 = instance.get();
+    BOOST_REQUIRE(!row2->request().inventories().empty());
+    BOOST_REQUIRE(row0->stopped() != row1->stopped());
+
+    // The waker is retained so that the partitioned channel restarts.
+    const auto maximal = row0->stopped() ? row0 : row1;
+    BOOST_REQUIRE_EQUAL(woken0 + woken1, 1u);
+    BOOST_REQUIRE_EQUAL(maximal->channel(), row0->stopped() ? 42u : 43u);
+}
+
+BOOST_AUTO_TEST_CASE(reservations__partition__reassigned_row__not_stopped_by_prior_channel)
+{
+    reservations instance(2, 1.5f, 5, 0, 0);
+    push(instance);
+    const auto row0 = instance.get();
+    const auto row1 = instance.get();
+    instance.distribute();
+    row0->set_waker(42, [](const code&) {});
+    row1->set_waker(43, [](const code&) {});
+    BOOST_REQUIRE(!row0->request().inventories().empty());
+    BOOST_REQUIRE(!row1->request().inventories().empty());
+    BOOST_REQUIRE(!instance.get()->request().inventories().empty());
+
+    const auto maximal = row0->stopped() ? row0 : row1;
+    const auto prior = maximal->channel();
+
+    // The stopped row is reassigned before its prior channel stops.
+    BOOST_REQUIRE(instance.get() == maximal);
+    BOOST_REQUIRE_EQUAL(maximal->channel(), 0u);
+    maximal->set_waker(44, [](const code&) {});
+
+    maximal->stop(prior);
+    BOOST_REQUIRE(!maximal->stopped());
+    BOOST_REQUIRE_EQUAL(maximal->channel(), 44u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(rolling_filter_tests)
+
+static const hash_digest hash1{ { 1 } };
+static const hash_digest hash2{ { 2 } };
+
+static hash_digest to_hash(uint32_t value)
+{
+    return bitcoin_hash(to_chunk(to_little_endian(value)));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_filter__contains__empty__false)
+{
+    const rolling_filter instance(100, 0.000001);
+    BOOST_REQUIRE(!instance.contains(hash1));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_filter__contains__inserted__true)
+{
+    rolling_filter instance(100, 0.000001);
+    instance.insert(hash1);
+    BOOST_REQUIRE(instance.contains(hash1));
+    BOOST_REQUIRE(!instance.contains(hash2));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_filter__contains__recent_half_capacity__true)
+{
+    rolling_filter instance(100, 0.000001);
+
+    for (uint32_t value = 0; value < 1000; ++value)
+        instance.insert(to_hash(value));
+
+    for (uint32_t value = 950; value < 1000; ++value)
+        BOOST_REQUIRE(instance.contains(to_hash(value)));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_filter__contains__rolled_out__false)
+{
+    rolling_filter instance(100, 0.000001);
+    instance.insert(hash1);
+
+    for (uint32_t value = 0; value < 100; ++value)
+        instance.insert(to_hash(value));
+
+    BOOST_REQUIRE(!instance.contains(hash1));
+}
+
+BOOST_AUTO_TEST_CASE(rolling_filter__clear__inserted__false)
+{
+    rolling_filter instance(100, 0.000001);
+    instance.insert(hash1);
+    instance.clear();
+    BOOST_REQUIRE(!instance.contains(hash1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -31,6 +31,13 @@ BOOST_AUTO_TEST_CASE(settings__construct__default_context__expected)
     node::settings configuration;
     BOOST_REQUIRE(!configuration.refresh_transactions);
     BOOST_REQUIRE_EQUAL(configuration.block_latency_seconds, 5u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_outbound_connections, 24u);
+    BOOST_REQUIRE_EQUAL(configuration.download_budget_megabytes, 1024u);
+    BOOST_REQUIRE_EQUAL(configuration.download_lookahead_blocks, 5000u);
+    BOOST_REQUIRE_EQUAL(configuration.store_threads, 0u);
+    BOOST_REQUIRE(!configuration.store_priority);
+    BOOST_REQUIRE_EQUAL(configuration.upload_kilobytes_per_second, 0u);
+    BOOST_REQUIRE(!configuration.compact_filters);
 }
 
 BOOST_AUTO_TEST_CASE(settings__construct__none_context__expected)
@@ -38,6 +45,13 @@ BOOST_AUTO_TEST_CASE(settings__construct__none_context__expected)
     node::settings configuration(config::settings::none);
     BOOST_REQUIRE(!configuration.refresh_transactions);
     BOOST_REQUIRE_EQUAL(configuration.block_latency_seconds, 5u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_outbound_connections, 24u);
+    BOOST_REQUIRE_EQUAL(configuration.download_budget_megabytes, 1024u);
+    BOOST_REQUIRE_EQUAL(configuration.download_lookahead_blocks, 5000u);
+    BOOST_REQUIRE_EQUAL(configuration.store_threads, 0u);
+    BOOST_REQUIRE(!configuration.store_priority);
+    BOOST_REQUIRE_EQUAL(configuration.upload_kilobytes_per_second, 0u);
+    BOOST_REQUIRE(!configuration.compact_filters);
 }
 
 BOOST_AUTO_TEST_CASE(settings__construct__mainnet_context__expected)
@@ -45,6 +59,13 @@ BOOST_AUTO_TEST_CASE(settings__construct__mainnet_context__expected)
     node::settings configuration(config::settings::mainnet);
     BOOST_REQUIRE(!configuration.refresh_transactions);
     BOOST_REQUIRE_EQUAL(configuration.block_latency_seconds, 5u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_outbound_connections, 24u);
+    BOOST_REQUIRE_EQUAL(configuration.download_budget_megabytes, 1024u);
+    BOOST_REQUIRE_EQUAL(configuration.download_lookahead_blocks, 5000u);
+    BOOST_REQUIRE_EQUAL(configuration.store_threads, 0u);
+    BOOST_REQUIRE(!configuration.store_priority);
+    BOOST_REQUIRE_EQUAL(configuration.upload_kilobytes_per_second, 0u);
+    BOOST_REQUIRE(!configuration.compact_filters);
 }
 
 BOOST_AUTO_TEST_CASE(settings__construct__testnet_context__expected)
@@ -52,6 +73,13 @@ BOOST_AUTO_TEST_CASE(settings__construct__testnet_context__expected)
     node::settings configuration(config::settings::testnet);
     BOOST_REQUIRE(!configuration.refresh_transactions);
     BOOST_REQUIRE_EQUAL(configuration.block_latency_seconds, 5u);
+    BOOST_REQUIRE_EQUAL(configuration.sync_outbound_connections, 24u);
+    BOOST_REQUIRE_EQUAL(configuration.download_budget_megabytes, 1024u);
+    BOOST_REQUIRE_EQUAL(configuration.download_lookahead_blocks, 5000u);
+    BOOST_REQUIRE_EQUAL(configuration.store_threads, 0u);
+    BOOST_REQUIRE(!configuration.store_priority);
+    BOOST_REQUIRE_EQUAL(configuration.upload_kilobytes_per_second, 0u);
+    BOOST_REQUIRE(!configuration.compact_filters);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
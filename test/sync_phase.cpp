@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(sync_phase_tests)
+
+// syncing
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(sync_phase__syncing__default__true)
+{
+    sync_phase instance;
+    BOOST_REQUIRE(instance.syncing());
+}
+
+// update
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(sync_phase__update__current__not_syncing)
+{
+    sync_phase instance;
+    instance.update(false);
+    BOOST_REQUIRE(!instance.syncing());
+}
+
+BOOST_AUTO_TEST_CASE(sync_phase__update__behind_after_current__syncing)
+{
+    sync_phase instance;
+    instance.update(false);
+    instance.update(true);
+    BOOST_REQUIRE(instance.syncing());
+}
+
+BOOST_AUTO_TEST_CASE(sync_phase__update__stopped__unchanged)
+{
+    sync_phase instance;
+    instance.stop();
+    instance.update(false);
+    BOOST_REQUIRE(instance.syncing());
+}
+
+// defer
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(sync_phase__defer__current__false)
+{
+    sync_phase instance;
+    instance.update(false);
+    auto upgraded = false;
+    BOOST_REQUIRE(!instance.defer(nullptr, [&](network::channel::ptr)
+    {
+        upgraded = true;
+    }));
+
+    BOOST_REQUIRE(!upgraded);
+}
+
+BOOST_AUTO_TEST_CASE(sync_phase__defer__stopped__false)
+{
+    sync_phase instance;
+    instance.stop();
+    BOOST_REQUIRE(!instance.defer(nullptr, [](network::channel::ptr) {}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <future>
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(timing_wheel_tests)
+
+static const auto delay = asio::milliseconds(10);
+
+// schedule
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(timing_wheel__schedule__distinct_keys__size_2)
+{
+    threadpool pool;
+    timing_wheel instance(pool, 10, 8);
+    instance.schedule(1, delay, [](const code&) {});
+    instance.schedule(2, delay, [](const code&) {});
+    BOOST_REQUIRE_EQUAL(instance.size(), 2u);
+    instance.stop();
+}
+
+BOOST_AUTO_TEST_CASE(timing_wheel__schedule__same_key__replaced)
+{
+    threadpool pool;
+    timing_wheel instance(pool, 10, 8);
+    instance.schedule(1, delay, [](const code&) {});
+    instance.schedule(1, delay * 100, [](const code&) {});
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    instance.stop();
+}
+
+BOOST_AUTO_TEST_CASE(timing_wheel__schedule__stopped__not_scheduled)
+{
+    threadpool pool;
+    timing_wheel instance(pool, 10, 8);
+    instance.stop();
+    instance.schedule(1, delay, [](const code&) {});
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(timing_wheel__schedule__beyond_wheel__expires)
+{
+    threadpool pool(1);
+    timing_wheel instance(pool, 1, 4);
+    std::promise<code> expired;
+    instance.schedule(1, delay, [&](const code& ec)
+    {
+        expired.set_value(ec);
+    });
+
+    auto result = expired.get_future();
+    BOOST_REQUIRE(result.wait_for(std::chrono::seconds(5)) ==
+        std::future_status::ready);
+    BOOST_REQUIRE_EQUAL(result.get(), error::success);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    instance.stop();
+    pool.shutdown();
+    pool.join();
+}
+
+// cancel
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(timing_wheel__cancel__scheduled__removed)
+{
+    threadpool pool;
+    timing_wheel instance(pool, 10, 8);
+    instance.schedule(1, delay, [](const code&) {});
+    instance.cancel(1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    instance.stop();
+}
+
+BOOST_AUTO_TEST_CASE(timing_wheel__cancel__unknown__unchanged)
+{
+    threadpool pool;
+    timing_wheel instance(pool, 10, 8);
+    instance.schedule(1, delay, [](const code&) {});
+    instance.cancel(2);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    instance.stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
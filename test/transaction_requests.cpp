@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(transaction_requests_tests)
+
+static const hash_digest hash1{ { 1 } };
+static const hash_digest hash2{ { 2 } };
+
+// announce
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(transaction_requests__announce__outbound__true)
+{
+    transaction_requests instance(60, 2);
+    instance.add(42, true);
+    BOOST_REQUIRE(instance.announce(42, hash1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_requests__announce__in_flight__false)
+{
+    transaction_requests instance(60, 2);
+    instance.add(42, true);
+    instance.add(43, true);
+    BOOST_REQUIRE(instance.announce(42, hash1));
+    BOOST_REQUIRE(!instance.announce(43, hash1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_requests__announce__inbound__deferred)
+{
+    transaction_requests instance(60, 0);
+    instance.add(42, false);
+    BOOST_REQUIRE(!instance.announce(42, hash1));
+
+    const auto hashes = instance.reassigned(42);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+    BOOST_REQUIRE(hashes.front() == hash1);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_requests__announce__unregistered__untracked)
+{
+    transaction_requests instance(60, 2);
+    BOOST_REQUIRE(!instance.announce(42, hash1));
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_requests__announce__channel_saturated__untracked)
+{
+    static const size_t limit = 5000;
+    transaction_requests instance(60, 2);
+    instance.add(42, true);
+
+    for (size_t index = 0; index < limit; ++index)
+    {
+        hash_digest hash{};
+        hash[0] = static_cast<uint8_t>(index);
+        hash[1] = static_cast<uint8_t>(index >> 8);
+        BOOST_REQUIRE(instance.announce(42, hash));
+    }
+
+    BOOST_REQUIRE(!instance.announce(42, hash1));
+    BOOST_REQUIRE_EQUAL(instance.size(), limit);
+}
+
+// complete
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(transaction_requests__complete__requested__removed)
+{
+    transaction_requests instance(60, 2);
+    instance.add(42, true);
+    BOOST_REQUIRE(instance.announce(42, hash1));
+    instance.complete(42, hash1);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+// not_found
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(transaction_requests__not_found__other_announcer__reassigned)
+{
+    transaction_requests instance(60, 2);
+    instance.add(42, true);
+    instance.add(43, true);
+    BOOST_REQUIRE(instance.announce(42, hash1));
+    BOOST_REQUIRE(!instance.announce(43, hash1));
+    instance.not_found(42, hash1);
+
+    const auto hashes = instance.reassigned(43);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+    BOOST_REQUIRE(hashes.front() == hash1);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_requests__not_found__no_other_announcer__dropped)
+{
+    transaction_requests instance(60, 2);
+    instance.add(42, true);
+    BOOST_REQUIRE(instance.announce(42, hash1));
+    instance.not_found(42, hash1);
+    BOOST_REQUIRE(instance.reassigned(42).empty());
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(transaction_requests__not_found__measured_announcer__preferred)
+{
+    transaction_requests instance(60, 2);
+    instance.add(42, true);
+    instance.add(43, true);
+    instance.add(44, true);
+
+    // Measure channel 42.
+    BOOST_REQUIRE(instance.announce(42, hash1));
+    instance.complete(42, hash1);
+
+    BOOST_REQUIRE(instance.announce(43, hash2));
+    BOOST_REQUIRE(!instance.announce(44, hash2));
+    BOOST_REQUIRE(!instance.announce(42, hash2));
+    instance.not_found(43, hash2);
+
+    const auto hashes = instance.reassigned(42);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+    BOOST_REQUIRE(hashes.front() == hash2);
+    BOOST_REQUIRE(instance.reassigned(44).empty());
+}
+
+// remove
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(transaction_requests__remove__requested__reassigned)
+{
+    transaction_requests instance(60, 2);
+    instance.add(42, true);
+    instance.add(43, false);
+    BOOST_REQUIRE(instance.announce(42, hash1));
+    BOOST_REQUIRE(!instance.announce(43, hash1));
+    instance.remove(42);
+
+    const auto hashes = instance.reassigned(43);
+    BOOST_REQUIRE_EQUAL(hashes.size(), 1u);
+    BOOST_REQUIRE(hashes.front() == hash1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2011-2017 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/unit_test.hpp>
+#include <bitcoin/node.hpp>
+
+using namespace bc;
+using namespace bc::node;
+
+BOOST_AUTO_TEST_SUITE(upload_scheduler_tests)
+
+static const hash_digest hash1{ { 1 } };
+static const hash_digest hash2{ { 2 } };
+
+// enqueue
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(upload_scheduler__enqueue__idle__granted)
+{
+    threadpool pool;
+    upload_scheduler instance(pool, 0);
+    auto granted = false;
+    instance.enqueue(42, hash1, [&](const code& ec)
+    {
+        granted = !ec;
+    });
+
+    BOOST_REQUIRE(granted);
+}
+
+BOOST_AUTO_TEST_CASE(upload_scheduler__enqueue__maximum_grants__deferred)
+{
+    threadpool pool;
+    upload_scheduler instance(pool, 0);
+    size_t granted = 0;
+    const auto handler = [&](const code& ec)
+    {
+        granted += ec ? 0 : 1;
+    };
+
+    for (uint64_t channel = 0; channel < 5; ++channel)
+        instance.enqueue(channel, hash1, handler);
+
+    BOOST_REQUIRE_EQUAL(granted, 4u);
+    instance.complete(0, hash1, 42);
+    BOOST_REQUIRE_EQUAL(granted, 5u);
+}
+
+BOOST_AUTO_TEST_CASE(upload_scheduler__enqueue__announced__granted_despite_full)
+{
+    threadpool pool;
+    upload_scheduler instance(pool, 0);
+    size_t granted = 0;
+    const auto handler = [&](const code& ec)
+    {
+        granted += ec ? 0 : 1;
+    };
+
+    for (uint64_t channel = 0; channel < 4; ++channel)
+        instance.enqueue(channel, hash1, handler);
+
+    instance.announce(hash2);
+    instance.enqueue(4, hash2, handler);
+    BOOST_REQUIRE_EQUAL(granted, 5u);
+}
+
+BOOST_AUTO_TEST_CASE(upload_scheduler__enqueue__stopped__service_stopped)
+{
+    threadpool pool;
+    upload_scheduler instance(pool, 0);
+    instance.stop();
+    code result;
+    instance.enqueue(42, hash1, [&](const code& ec)
+    {
+        result = ec;
+    });
+
+    BOOST_REQUIRE_EQUAL(result, error::service_stopped);
+}
+
+// remove
+//-----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(upload_scheduler__remove__granted__releases_grant)
+{
+    threadpool pool;
+    upload_scheduler instance(pool, 0);
+    size_t granted = 0;
+    const auto handler = [&](const code& ec)
+    {
+        granted += ec ? 0 : 1;
+    };
+
+    for (uint64_t channel = 0; channel < 5; ++channel)
+        instance.enqueue(channel, hash1, handler);
+
+    instance.remove(2);
+    BOOST_REQUIRE_EQUAL(granted, 5u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()